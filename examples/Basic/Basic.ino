@@ -23,5 +23,6 @@ void loop() {
   // Use idle() for delays - this tells governor you're not working
   PicomimiGov.idle(10);  // 10ms idle = low CPU load
   
-  // Using delay() works too, but idle() gives more accurate tracking
+  // delay() is seen as idle too (the core sleeps in WFE), but idle()
+  // also feeds the deadline controller and can use the sleep backend
 }
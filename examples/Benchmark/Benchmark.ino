@@ -0,0 +1,233 @@
+/*
+ * PICOMIMI GOVERNOR - Benchmark Suite
+ *
+ * Runs fixed kernels at every operating point, then once more with the
+ * governor in auto mode, and prints one CSV row per kernel per pass:
+ *
+ *   mode,mhz,kernel,ops_s,ops_s_mhz,mw,ops_mj,run_cyc,stall_us
+ *
+ * - mode:      "fixed" (pinned with setOpp) or "auto"
+ * - mhz:       clock during the run, averaged in auto mode
+ * - ops_s:     kernel iterations per second (sizes below)
+ * - mw, ops_mj: power and work per millijoule, from the governor's model
+ *              or a real INA219 reading with USE_INA219
+ * - run_cyc:   average cycles per run() call made between iterations
+ * - stall_us:  the transition into the level (auto: worst in the run)
+ *
+ * Kernels, one iteration each:
+ * - int:    8x8 matrix multiply, a state-machine scan and a CRC-16
+ *           over 64 bytes (CoreMark-style mix, not CoreMark itself)
+ * - crc32:  bitwise CRC-32 over 256 bytes
+ * - float:  64-point multiply-accumulate plus a sqrtf
+ * - memcpy: 4 KB SRAM to SRAM
+ * - xip:    256 word reads striding through 256 KB of flash, well past
+ *           the XIP cache, so the flash clock sets the pace
+ *
+ * Auto mode keeps the core 100% busy, so it shows the ramp to the top
+ * level and run()'s cost, not policy choices. Passes repeat forever;
+ * keep a log for a regression baseline across library versions.
+ */
+
+#include <PicomimiGovernor.h>
+#include <math.h>
+
+#define KERNEL_MS        250       // Measured time per kernel per level
+#define SETTLE_MS        50        // After each level change
+#define PASS_PAUSE_MS    5000
+#define USE_INA219       0         // 1 = real power from an INA219 on Wire
+
+#if USE_INA219
+#include <Adafruit_INA219.h>
+Adafruit_INA219 ina219;
+#endif
+
+// ============================================================================
+// KERNELS
+// ============================================================================
+
+static int16_t mat_a[64], mat_b[64], mat_c[64];
+static uint8_t text[256];
+static uint8_t sram_src[4096], sram_dst[4096];
+static float vec_a[64], vec_b[64];
+static volatile uint32_t sink;   // Keeps results live
+
+static uint16_t crc16(const uint8_t* p, uint32_t n) {
+  uint16_t crc = 0xFFFF;
+  while (n--) {
+    crc ^= *p++;
+    for (uint8_t b = 0; b < 8; b++) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+  }
+  return crc;
+}
+
+static void kernelInt() {
+  for (uint8_t i = 0; i < 8; i++) {
+    for (uint8_t j = 0; j < 8; j++) {
+      int32_t acc = 0;
+      for (uint8_t k = 0; k < 8; k++) acc += mat_a[i * 8 + k] * mat_b[k * 8 + j];
+      mat_c[i * 8 + j] = (int16_t)acc;
+    }
+  }
+  // Count digit runs, CoreMark's core_state in miniature
+  uint8_t state = 0, runs = 0;
+  for (uint8_t i = 0; i < 64; i++) {
+    bool digit = text[i] >= '0' && text[i] <= '9';
+    if (digit && state == 0) runs++;
+    state = digit;
+  }
+  sink = mat_c[(runs + sink) & 63] + crc16(text, 64);
+}
+
+static void kernelCrc32() {
+  uint32_t crc = 0xFFFFFFFF;
+  for (uint16_t i = 0; i < 256; i++) {
+    crc ^= text[i];
+    for (uint8_t b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  sink = ~crc;
+}
+
+static void kernelFloat() {
+  float acc = 0;
+  for (uint8_t i = 0; i < 64; i++) acc += vec_a[i] * vec_b[i];
+  sink = (uint32_t)sqrtf(acc > 0 ? acc : -acc);
+}
+
+static void kernelMemcpy() {
+  memcpy(sram_dst, sram_src, sizeof(sram_dst));
+  sink = sram_dst[sink & 4095];
+}
+
+static void kernelXip() {
+  static uint32_t offset = 0;
+  const volatile uint32_t* flash = (const volatile uint32_t*)XIP_BASE;
+  uint32_t acc = 0;
+  for (uint16_t i = 0; i < 256; i++) {
+    acc += flash[offset / 4];
+    offset = (offset + 1024 + 4) & (256 * 1024 - 1);   // Skew to hit every line
+  }
+  sink = acc;
+}
+
+struct Kernel {
+  const char* name;
+  void (*fn)();
+};
+
+static const Kernel KERNELS[] = {
+  { "int",    kernelInt },
+  { "crc32",  kernelCrc32 },
+  { "float",  kernelFloat },
+  { "memcpy", kernelMemcpy },
+  { "xip",    kernelXip },
+};
+
+// ============================================================================
+// MEASUREMENT
+// ============================================================================
+
+static float powerNowMw() {
+#if USE_INA219
+  return ina219.getPower_mW();
+#else
+  return 0;
+#endif
+}
+
+static void runKernel(const char* mode, const Kernel& k, uint32_t stall_us) {
+  uint32_t ops = 0, runs = 0;
+  uint64_t run_cycles = 0, mhz_sum = 0;
+  float ina_mw = 0;
+  uint64_t uj0 = PicomimiGov.getEnergyUj();
+  uint64_t t0 = time_us_64(), end = t0 + KERNEL_MS * 1000ULL, half = t0 + KERNEL_MS * 500ULL;
+  uint64_t excluded = 0;
+  uint32_t changes = PicomimiGov.getTransitionCount();
+
+  uint64_t now;
+  while ((now = time_us_64()) < end) {
+    k.fn();
+    ops++;
+
+    uint32_t c0 = rp2040.getCycleCount();
+    PicomimiGov.run();
+    run_cycles += rp2040.getCycleCount() - c0;
+    runs++;
+    mhz_sum += PicomimiGov.getFreqMHz();
+    if (PicomimiGov.getTransitionCount() != changes) {
+      changes = PicomimiGov.getTransitionCount();
+      uint32_t stall = PicomimiGov.getTransitionStallUs();
+      if (stall > stall_us) stall_us = stall;
+    }
+
+    // One power reading mid-run, left out of the timing
+    if (USE_INA219 && half && now >= half) {
+      ina_mw = powerNowMw();
+      excluded += time_us_64() - now;
+      half = 0;
+    }
+  }
+
+  uint64_t us = now - t0 - excluded;
+  float mhz = (float)mhz_sum / runs;
+  float ops_s = ops * 1e6f / us;
+  float mw = USE_INA219 ? ina_mw : (PicomimiGov.getEnergyUj() - uj0) * 1000.0f / (now - t0);
+
+  Serial.print(mode); Serial.print(',');
+  Serial.print(mhz, 1); Serial.print(',');
+  Serial.print(k.name); Serial.print(',');
+  Serial.print(ops_s, 1); Serial.print(',');
+  Serial.print(ops_s / mhz, 2); Serial.print(',');
+  Serial.print(mw, 2); Serial.print(',');
+  Serial.print(mw > 0 ? ops_s / mw : 0, 2); Serial.print(',');
+  Serial.print((uint32_t)(run_cycles / runs)); Serial.print(',');
+  Serial.println(stall_us);
+}
+
+// ============================================================================
+// SKETCH
+// ============================================================================
+
+void setup() {
+  Serial.begin(115200);
+  delay(2000);
+
+  for (uint8_t i = 0; i < 64; i++) {
+    mat_a[i] = i * 3 - 90;
+    mat_b[i] = 50 - i;
+    vec_a[i] = i * 0.25f;
+    vec_b[i] = 1.0f / (i + 1);
+  }
+  for (uint16_t i = 0; i < sizeof(text); i++) text[i] = (i % 7 < 3) ? '0' + i % 10 : 'a' + i % 26;
+  for (uint16_t i = 0; i < sizeof(sram_src); i++) sram_src[i] = i * 31;
+
+#if USE_INA219
+  ina219.begin();
+#endif
+
+  PicomimiGov.begin(PICOMIMI_RP2350);  // or PICOMIMI_RP2040
+
+  Serial.println(F("mode,mhz,kernel,ops_s,ops_s_mhz,mw,ops_mj,run_cyc,stall_us"));
+}
+
+void loop() {
+  // Without the governor deciding: every point, pinned
+  for (uint8_t level = 0; level < PicomimiGov.getOppCount(); level++) {
+    PicomimiGov.setOpp(level);
+    uint32_t stall = PicomimiGov.getTransitionStallUs();
+    delay(SETTLE_MS);
+#if USE_INA219
+    PicomimiGov.setMeasuredCurrent(ina219.getCurrent_mA());
+#endif
+    for (const Kernel& k : KERNELS) runKernel("fixed", k, stall);
+  }
+
+  // With it: start from the bottom each time so the ramp is measured
+  for (const Kernel& k : KERNELS) {
+    PicomimiGov.setOpp(0);
+    delay(SETTLE_MS);
+    PicomimiGov.setAuto();
+    runKernel("auto", k, 0);
+  }
+
+  delay(PASS_PAUSE_MS);
+}
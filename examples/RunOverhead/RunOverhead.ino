@@ -0,0 +1,73 @@
+/*
+ * PICOMIMI GOVERNOR - run() Overhead Benchmark
+ *
+ * Times every run() call in cycles and splits them into:
+ * - fast path: no decision due, just the timer read and accounting
+ * - slow path: the once-per-100ms load/thermal/scaling pass
+ *
+ * Reports alternate between the ladder and the predictive policy, whose
+ * burst check also sits on run()'s fast path. A one-point table holds
+ * the clock still while the policy keeps running (an override would
+ * skip it). Results print every few seconds.
+ */
+
+#include <PicomimiGovernor.h>
+
+#define CALLS_PER_REPORT 200000
+#define SLOW_FACTOR      4        // Calls this many times the fastest are slow path
+
+static const OperatingPoint ONE_POINT[] = { { 50000, 950 } };
+
+void setup() {
+  Serial.begin(115200);
+  delay(2000);
+
+  PicomimiGov.setOperatingPoints(ONE_POINT, 1);
+  PicomimiGov.begin(PICOMIMI_RP2350);  // or PICOMIMI_RP2040
+}
+
+void loop() {
+  static bool predictive = false;
+  PicomimiGov.setPolicy(predictive ? POLICY_PREDICTIVE : POLICY_LADDER);
+
+  // Cost of the timing itself
+  uint32_t t0 = rp2040.getCycleCount();
+  uint32_t t1 = rp2040.getCycleCount();
+  uint32_t bias = t1 - t0;
+
+  uint32_t fastest = 0xFFFFFFFF;
+  uint64_t fast_sum = 0, slow_sum = 0;
+  uint32_t fast_n = 0, slow_n = 0, slow_max = 0;
+
+  for (uint32_t i = 0; i < CALLS_PER_REPORT; i++) {
+    t0 = rp2040.getCycleCount();
+    PicomimiGov.run();
+    t1 = rp2040.getCycleCount();
+
+    uint32_t cycles = t1 - t0;
+    cycles = cycles > bias ? cycles - bias : 0;
+    if (cycles < fastest) fastest = cycles;
+
+    if (cycles > fastest * SLOW_FACTOR && cycles > 50) {
+      slow_sum += cycles;
+      slow_n++;
+      if (cycles > slow_max) slow_max = cycles;
+    } else {
+      fast_sum += cycles;
+      fast_n++;
+    }
+  }
+
+  Serial.print(F("[BENCH] "));
+  Serial.print(predictive ? F("predictive ") : F("ladder     "));
+  Serial.print(rp2040.f_cpu() / 1000000); Serial.print(F(" MHz  fast: "));
+  Serial.print(fast_n ? (uint32_t)(fast_sum / fast_n) : 0); Serial.print(F(" cyc avg ("));
+  Serial.print(fastest); Serial.print(F(" min, ")); Serial.print(fast_n);
+  Serial.print(F(" calls)  slow: "));
+  Serial.print(slow_n ? (uint32_t)(slow_sum / slow_n) : 0); Serial.print(F(" cyc avg ("));
+  Serial.print(slow_max); Serial.print(F(" max, ")); Serial.print(slow_n);
+  Serial.println(F(" calls)"));
+
+  predictive = !predictive;
+  delay(3000);
+}
@@ -0,0 +1,307 @@
+/*
+ * PICOMIMI GOVERNOR - Policy Simulator
+ *
+ * Replays a workload against each policy variant, using the same
+ * PicomimiPolicy code the governor runs, and reports energy, deadline
+ * misses, transitions and time-to-max-frequency.
+ *
+ *   ./sim                          built-in synthetic workloads
+ *   ./sim trace.csv                a recorded workload
+ *   ./sim --chip rp2350 --deadline 20 --csv trace.csv
+ *
+ * A workload CSV needs a time_ms column and either demand_mhz (work per
+ * second, as the clock it would fully load) or instant_load + mhz, which
+ * is what extras/trace_decode.py prints. Each row holds until the next.
+ *
+ * Model, at 1 ms steps: work arrives, runs at the current clock, and
+ * whatever doesn't fit queues. A frequency change costs SIM_STALL_US of
+ * no progress. Load windows and decisions follow the governor's timing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+
+#include "PicomimiPolicy.h"
+
+#define SIM_STALL_US      60      // Typical measured same-VCO transition
+#define SIM_SUPPLY_MV     3300
+#define SIM_MAX_OPPS      24
+
+// ============================================================================
+// WORKLOADS
+// ============================================================================
+
+struct Sample {
+  uint32_t time_ms;
+  float demand_mhz;
+};
+
+struct Workload {
+  std::string name;
+  std::vector<Sample> samples;
+  uint32_t length_ms;
+};
+
+static Workload synthetic(const char* name) {
+  Workload w;
+  w.name = name;
+  if (!strcmp(name, "steady")) {
+    w.samples.push_back({ 0, 60.0f });
+    w.length_ms = 10000;
+  } else if (!strcmp(name, "bursty")) {
+    // 40 ms of heavy work every 500 ms over a light background
+    for (uint32_t t = 0; t < 20000; t += 500) {
+      w.samples.push_back({ t, 180.0f });
+      w.samples.push_back({ t + 40, 8.0f });
+    }
+    w.length_ms = 20000;
+  } else if (!strcmp(name, "ramp")) {
+    // Up to 240 MHz of demand and back down over 20 s
+    for (uint32_t t = 0; t < 20000; t += 100) {
+      float x = t < 10000 ? t / 10000.0f : (20000 - t) / 10000.0f;
+      w.samples.push_back({ t, 240.0f * x });
+    }
+    w.length_ms = 20000;
+  } else if (!strcmp(name, "step")) {
+    // Idle, then a sustained load that needs the top of the table
+    w.samples.push_back({ 0, 2.0f });
+    w.samples.push_back({ 3000, 230.0f });
+    w.samples.push_back({ 8000, 2.0f });
+    w.length_ms = 12000;
+  }
+  return w;
+}
+
+static int column(const std::vector<std::string>& head, const char* name) {
+  for (size_t i = 0; i < head.size(); i++) {
+    if (head[i] == name) return (int)i;
+  }
+  return -1;
+}
+
+static std::vector<std::string> split(const char* line) {
+  std::vector<std::string> out;
+  std::string cur;
+  for (const char* p = line; *p && *p != '\n' && *p != '\r'; p++) {
+    if (*p == ',') { out.push_back(cur); cur.clear(); }
+    else cur += *p;
+  }
+  out.push_back(cur);
+  return out;
+}
+
+static bool loadCsv(const char* path, Workload& w) {
+  FILE* f = fopen(path, "r");
+  if (!f) { fprintf(stderr, "sim: can't open %s\n", path); return false; }
+
+  char line[512];
+  if (!fgets(line, sizeof(line), f)) { fclose(f); return false; }
+  std::vector<std::string> head = split(line);
+  int c_time = column(head, "time_ms");
+  int c_demand = column(head, "demand_mhz");
+  int c_load = column(head, "instant_load");
+  int c_mhz = column(head, "mhz");
+  if (c_time < 0 || (c_demand < 0 && (c_load < 0 || c_mhz < 0))) {
+    fprintf(stderr, "sim: %s needs time_ms and demand_mhz (or instant_load + mhz)\n", path);
+    fclose(f);
+    return false;
+  }
+
+  w.name = path;
+  uint32_t t0 = 0;
+  while (fgets(line, sizeof(line), f)) {
+    std::vector<std::string> cells = split(line);
+    if ((int)cells.size() < (int)head.size()) continue;
+    uint32_t t = (uint32_t)strtoul(cells[c_time].c_str(), nullptr, 10);
+    float demand = c_demand >= 0 ? strtof(cells[c_demand].c_str(), nullptr)
+                                 : strtof(cells[c_load].c_str(), nullptr) *
+                                   strtof(cells[c_mhz].c_str(), nullptr) / 100.0f;
+    if (w.samples.empty()) t0 = t;
+    w.samples.push_back({ t - t0, demand });
+  }
+  fclose(f);
+
+  if (w.samples.empty()) return false;
+  // Hold the last row one decision window
+  w.length_ms = w.samples.back().time_ms + PICOMIMI_LOAD_PERIOD_MS;
+  return true;
+}
+
+// ============================================================================
+// POLICY VARIANTS
+// ============================================================================
+
+// The governor's built-in policy targets, minus predictive (which needs
+// the per-iteration burst history run() sees)
+static const PolicyOps VARIANTS[] = {
+  { "ladder",       policyTargetLadder },
+  { "conservative", policyTargetConservative },
+  { "ondemand",     policyTargetOndemand },
+  { "schedutil",    policyTargetSched },
+  { "interactive",  policyTargetInteractive },
+  { "powersave",    policyTargetPowersave },
+  { "performance",  policyTargetPerformance },
+};
+
+// ============================================================================
+// SIMULATION
+// ============================================================================
+
+struct Result {
+  double energy_mj;
+  double avg_mw;
+  double avg_mhz;
+  uint32_t misses;       // Times the queue went past the deadline
+  uint32_t late_ms;      // Time spent past it
+  uint32_t transitions;
+  double to_max_avg_ms;  // From demand outrunning the clock to top level
+  uint32_t to_max_worst_ms;
+  uint32_t to_max_count;
+};
+
+static Result simulate(const Workload& w, const PolicyOps& v, const PolicyOpp* t, uint8_t n,
+                       bool rp2350, uint32_t deadline_ms) {
+  Result r;
+  memset(&r, 0, sizeof(r));
+
+  LoadSample s;
+  memset(&s, 0, sizeof(s));
+  s.level = policyNearest(t, n, 125000);
+  s.ceiling = n - 1;
+  s.efficiency_pct = 100;
+  s.interval_ms = PICOMIMI_SCALE_INTERVAL_MS;
+  PolicyState state = { 0, 0 };
+  size_t next = 0;
+  float demand = 0;
+  double backlog = 0;               // MHz x ms of queued work
+  double window_busy = 0;
+  uint32_t window_ms = 0;
+  double energy_nj = 0;
+  double mhz_sum = 0;
+  bool late = false;
+  int64_t chase_start = -1;         // Demand > clock, not yet at the top
+  uint32_t stall_us = 0;
+
+  for (uint32_t ms = 0; ms < w.length_ms; ms++) {
+    while (next < w.samples.size() && w.samples[next].time_ms <= ms) demand = w.samples[next++].demand_mhz;
+
+    double mhz = t[s.level].khz / 1000.0;
+    double cap = mhz * (1000.0 - stall_us) / 1000.0;
+    stall_us = 0;
+
+    backlog += demand;
+    double done = backlog < cap ? backlog : cap;
+    backlog -= done;
+    double busy = done / mhz;        // Stall time counts as idle
+    window_busy += busy;
+    window_ms++;
+
+    uint8_t busy_pct = (uint8_t)(busy * 100.0 + 0.5);
+    energy_nj += (double)policyCurrentUa(t[s.level], busy_pct, rp2350) * SIM_SUPPLY_MV / 1000.0;
+    mhz_sum += mhz;
+
+    // Deadline: queued work that takes longer than the deadline to drain
+    bool now_late = backlog / mhz > deadline_ms;
+    if (now_late) r.late_ms++;
+    if (now_late && !late) r.misses++;
+    late = now_late;
+
+    // Time to max: from the clock falling behind until the top level
+    if (chase_start < 0 && demand > mhz && s.level < n - 1) chase_start = ms;
+    if (chase_start >= 0 && demand <= mhz && s.level < n - 1 && backlog == 0) chase_start = -1;
+    if (chase_start >= 0 && s.level == n - 1) {
+      uint32_t d = (uint32_t)(ms - chase_start);
+      r.to_max_avg_ms += d;
+      if (d > r.to_max_worst_ms) r.to_max_worst_ms = d;
+      r.to_max_count++;
+      chase_start = -1;
+    }
+
+    if (window_ms >= PICOMIMI_LOAD_PERIOD_MS) {
+      s.instant_load = (load_q16_t)(window_busy * PICOMIMI_LOAD_Q16(100) / window_ms);
+      s.avg_load = policySmooth(s.avg_load, s.instant_load, PICOMIMI_DEFAULT_TUNING.smooth_pct);
+      window_busy = 0;
+      window_ms = 0;
+    }
+
+    if ((ms + 1) % PICOMIMI_SCALE_INTERVAL_MS == 0) {
+      uint8_t target = v.target(t, n, s, PICOMIMI_DEFAULT_TUNING, state);
+      if (target >= n) target = n - 1;
+      if (target != s.level) {
+        s.level = target;
+        r.transitions++;
+        stall_us = SIM_STALL_US;
+      }
+    }
+  }
+
+  r.energy_mj = energy_nj / 1e6;
+  r.avg_mw = r.energy_mj / (w.length_ms / 1000.0);
+  r.avg_mhz = mhz_sum / w.length_ms;
+  if (r.to_max_count) r.to_max_avg_ms /= r.to_max_count;
+  return r;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void usage() {
+  fprintf(stderr, "usage: sim [--chip rp2040|rp2350] [--deadline ms] [--csv] [workload.csv ...]\n");
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  bool rp2350 = false;
+  bool csv = false;
+  uint32_t deadline_ms = 50;
+  std::vector<Workload> loads;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--chip") && i + 1 < argc) rp2350 = !strcmp(argv[++i], "rp2350");
+    else if (!strcmp(argv[i], "--deadline") && i + 1 < argc) deadline_ms = (uint32_t)atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--csv")) csv = true;
+    else if (argv[i][0] == '-') usage();
+    else {
+      Workload w;
+      if (!loadCsv(argv[i], w)) return 1;
+      loads.push_back(w);
+    }
+  }
+  if (loads.empty()) {
+    const char* names[] = { "steady", "bursty", "ramp", "step" };
+    for (const char* name : names) loads.push_back(synthetic(name));
+  }
+
+  PolicyOpp table[SIM_MAX_OPPS];
+  uint8_t n = policyBuiltin(table, rp2350, PICOMIMI_DEFAULT_TUNING);
+
+  if (csv) printf("workload,policy,energy_mj,avg_mw,avg_mhz,misses,late_ms,transitions,to_max_avg_ms,to_max_worst_ms\n");
+  else printf("%s, deadline %u ms\n", rp2350 ? "RP2350" : "RP2040", deadline_ms);
+
+  for (const Workload& w : loads) {
+    if (!csv) {
+      printf("\n%s (%.1f s)\n", w.name.c_str(), w.length_ms / 1000.0);
+      printf("  %-12s %10s %8s %8s %7s %8s %6s %14s\n",
+             "policy", "energy mJ", "avg mW", "avg MHz", "misses", "late ms", "trans", "to-max avg/max");
+    }
+    for (const PolicyOps& v : VARIANTS) {
+      Result r = simulate(w, v, table, n, rp2350, deadline_ms);
+      if (csv) {
+        printf("%s,%s,%.2f,%.2f,%.1f,%u,%u,%u,%.0f,%u\n", w.name.c_str(), v.name,
+               r.energy_mj, r.avg_mw, r.avg_mhz, r.misses, r.late_ms, r.transitions,
+               r.to_max_avg_ms, r.to_max_worst_ms);
+      } else {
+        char tmax[32];
+        if (r.to_max_count) snprintf(tmax, sizeof(tmax), "%.0f/%u", r.to_max_avg_ms, r.to_max_worst_ms);
+        else snprintf(tmax, sizeof(tmax), "-");
+        printf("  %-12s %10.1f %8.1f %8.1f %7u %8u %6u %14s\n", v.name, r.energy_mj, r.avg_mw,
+               r.avg_mhz, r.misses, r.late_ms, r.transitions, tmax);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""
+PICOMIMI GOVERNOR - telemetry stream decoder
+
+Reads the frames PicomimiGov.setTelemetry() writes and prints one CSV row
+per frame. Anything between frames (log text, a torn frame) is skipped.
+
+  telemetry_decode.py capture.bin          # from a captured file
+  telemetry_decode.py /dev/ttyACM0         # live, until Ctrl-C
+
+Frame: "PGTM", version u8, record size u8, OPP count u8, reserved u8,
+record, OPP count x residency u16 (per mille), CRC-32 (zlib) of everything
+before it, all little-endian.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+MAGIC = b"PGTM"
+RECORD = struct.Struct("<IIHHHhHHHBBBBBB")
+FIELDS = ["time_ms", "seq", "mhz", "cap_mhz", "temp_c", "core0_load", "core1_load",
+          "avg_load", "level", "transitions", "throttles", "stall_max_us",
+          "deadline_misses", "throttled", "override", "boost", "turbo", "residency"]
+
+
+def frames(data):
+    """Yields (row, end offset) for each valid frame in data."""
+    pos = 0
+    while True:
+        start = data.find(MAGIC, pos)
+        if start < 0 or len(data) < start + 8:
+            return
+        version, size, count = struct.unpack_from("<BBB", data, start + 4)
+        end = start + 8 + size + 2 * count
+        if version != 1 or size != RECORD.size:
+            pos = start + 1
+            continue
+        if len(data) < end + 4:
+            return
+        crc, = struct.unpack_from("<I", data, end)
+        if crc != zlib.crc32(data[start:end]):
+            pos = start + 1
+            continue
+
+        (t, transitions, seq, mhz, cap, temp, throttles, stall, misses,
+         load0, load1, avg, level, flags, _) = RECORD.unpack_from(data, start + 8)
+        res = struct.unpack_from(f"<{count}H", data, start + 8 + size)
+        yield ([t, seq, mhz, cap, temp / 10.0, load0, load1, avg, level, transitions,
+                throttles, stall, misses, flags & 1, (flags >> 1) & 1, (flags >> 2) & 1,
+                (flags >> 3) & 1, " ".join(f"{r / 10.0:.1f}" for r in res)], end + 4)
+        pos = end + 4
+
+
+def stream_serial(port, baud):
+    import serial  # pyserial
+    with serial.Serial(port, baud, timeout=1) as s:
+        buf = b""
+        while True:
+            buf += s.read(4096)
+            used = 0
+            for row, end in frames(buf):
+                yield row
+                used = end
+            buf = buf[used:] if used else buf[-256:]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("source", help="captured file or serial port")
+    ap.add_argument("--baud", type=int, default=115200)
+    args = ap.parse_args()
+
+    print(",".join(FIELDS))
+    if args.source.startswith(("/dev/", "COM")):
+        rows = stream_serial(args.source, args.baud)
+    else:
+        with open(args.source, "rb") as f:
+            rows = (row for row, _ in frames(f.read()))
+    try:
+        for r in rows:
+            print(",".join(str(v) for v in r), flush=True)
+    except KeyboardInterrupt:
+        sys.exit(0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+PICOMIMI GOVERNOR - decision trace decoder
+
+Reads the binary frame written by PicomimiGov.dumpTrace() (or the 'trace'
+serial command) and prints it as CSV, or plots it.
+
+  trace_decode.py dump.bin                 # from a captured file
+  trace_decode.py /dev/ttyACM0             # sends 'trace', reads the reply
+  trace_decode.py /dev/ttyACM0 --plot      # needs matplotlib
+
+Frame: "PGTR", version u8, record size u8, count u16, count x record,
+CRC-32 (zlib) of everything before it, all little-endian.
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+MAGIC = b"PGTR"
+RECORD = struct.Struct("<IhHHBBBBBB")
+REASONS = ["start", "load", "boost", "thermal", "override", "timeout", "deadline", "predict", "idle", "qos", "phase"]
+FIELDS = ["time_ms", "temp_c", "stall_us", "mhz", "instant_load", "avg_load",
+          "from", "to", "reason", "throttled", "override", "boost"]
+
+
+def read_serial(port, baud):
+    import serial  # pyserial
+    with serial.Serial(port, baud, timeout=2) as s:
+        s.reset_input_buffer()
+        s.write(b"trace\n")
+        data = b""
+        while True:
+            chunk = s.read(4096)
+            if not chunk:
+                return data
+            data += chunk
+
+
+def decode(data):
+    start = data.find(MAGIC)
+    if start < 0:
+        sys.exit("no PGTR frame found")
+    version, size, count = struct.unpack_from("<BBH", data, start + 4)
+    if version != 1 or size != RECORD.size:
+        sys.exit(f"unsupported frame: version {version}, record size {size}")
+
+    body_end = start + 8 + count * size
+    if len(data) < body_end + 4:
+        sys.exit("frame truncated")
+    crc, = struct.unpack_from("<I", data, body_end)
+    if crc != zlib.crc32(data[start:body_end]):
+        sys.exit("CRC mismatch")
+
+    rows = []
+    for i in range(count):
+        rec = RECORD.unpack_from(data, start + 8 + i * size)
+        if not any(rec):
+            continue  # Overwritten while the dump was being sent
+        t, temp, stall, mhz, inst, avg, frm, to, reason, flags = rec
+        rows.append([t, temp / 10.0, stall, mhz, inst, avg, frm, to,
+                     REASONS[reason] if reason < len(REASONS) else str(reason),
+                     flags & 1, (flags >> 1) & 1, (flags >> 2) & 1])
+    return rows
+
+
+def plot(rows):
+    import matplotlib.pyplot as plt
+    t = [r[0] / 1000.0 for r in rows]
+    fig, (ax_f, ax_l) = plt.subplots(2, 1, sharex=True)
+    ax_f.step(t, [r[3] for r in rows], where="post")
+    ax_f.set_ylabel("MHz")
+    ax_t = ax_f.twinx()
+    ax_t.plot(t, [r[1] for r in rows], "r.", markersize=3)
+    ax_t.set_ylabel("°C")
+    ax_l.plot(t, [r[4] for r in rows], label="instant")
+    ax_l.plot(t, [r[5] for r in rows], label="avg")
+    ax_l.set_ylabel("load %")
+    ax_l.set_xlabel("s")
+    ax_l.legend()
+    plt.show()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("source", help="captured dump file or serial port")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--plot", action="store_true")
+    args = ap.parse_args()
+
+    if args.source.startswith(("/dev/", "COM")):
+        data = read_serial(args.source, args.baud)
+    else:
+        with open(args.source, "rb") as f:
+            data = f.read()
+
+    rows = decode(data)
+    if args.plot:
+        plot(rows)
+    else:
+        print(",".join(FIELDS))
+        for r in rows:
+            print(",".join(str(v) for v in r))
+
+
+if __name__ == "__main__":
+    main()
@@ -3,110 +3,385 @@
  * 
  * CPU Load Tracking Strategy:
  * 
- * The fundamental insight: REAL WORK TAKES TIME.
- * - Empty loop = runs in ~10-50us = idle (just loop overhead)
- * - Light work = 100us - 1ms = low-medium load
- * - Heavy work = 1ms+ = high load
- * - Delays = explicitly marked idle time
- * 
- * We measure time between run() calls (user code time) and use thresholds
- * to determine if actual work is happening or if it's just spinning.
+ * Load = 1 - idle / elapsed, per core, per window. Two idle sources,
+ * and the larger one counts:
+ * - Sampled: a raw timer alarm per core checks whether it interrupted a
+ *   WFE/WFI, whoever put the core there (delay(), sleep_ms(), libraries)
+ * - Declared, from the 1 MHz timer: time the governor itself spent
+ *   asleep (IDLE_SLEEP, RP2350 WFI) or spinning in idle(), plus loops
+ *   that do nothing but call run()
+ * - Interrupts that wake a sleep are serviced after the idle time is
+ *   booked, so ISR time counts as work in both
  */
 
 #include "PicomimiGovernor.h"
+#include <hardware/dma.h>
+#include <hardware/flash.h>
+#include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <hardware/timer.h>
+#include <hardware/watchdog.h>
+#include <hardware/xosc.h>
+#include <hardware/structs/scb.h>
+#include <hardware/structs/xip_ctrl.h>
+#include <hardware/structs/busctrl.h>
+#include <pico/multicore.h>
+
+#if PICO_RP2350
+#define SCR_SEVONPEND_BITS M33_SCR_SEVONPEND_BITS
+#else
+#define SCR_SEVONPEND_BITS M0PLUS_SCR_SEVONPEND_BITS
+#endif
+
+#if PICO_RP2350
+#include <hardware/structs/qmi.h>
+#else
+#include <hardware/structs/ssi.h>
+#include <hardware/structs/vreg_and_chip_reset.h>
+#endif
 
 // ============================================================================
 // TABLES
 // ============================================================================
 
-static const uint32_t RP2040_FREQ[] = { 50000, 100000, 133000, 200000, 250000 };
-static const uint32_t RP2040_VOLT[] = { 950, 1000, 1050, 1100, 1150 };
-static const uint32_t RP2350_FREQ[] = { 50000, 100000, 150000, 250000, 300000 };
-static const uint32_t RP2350_VOLT[] = { 950, 1000, 1050, 1100, 1250 };
+// Frequencies and voltages are in PicomimiPolicy.h, shared with extras/sim
+static_assert(PICOMIMI_BUILTIN_OPPS == PROFILE_COUNT, "one built-in point per profile");
+
 static const char* PROFILE_NAMES[] = { "ULTRA_LOW", "POWERSAVE", "BALANCED", "PERFORMANCE", "TURBO" };
 
+// ============================================================================
+// PLL TABLES
+// ============================================================================
+
+// Same search as check_sys_clock_khz(), done by the compiler. A VCO of
+// 1500 MHz is tried first: entries that share it switch by rewriting
+// the post dividers only, without waiting for the PLL to relock.
+#define PLL_REF_KHZ          12000
+#define PLL_VCO_MIN_KHZ      750000
+#define PLL_VCO_MAX_KHZ      1600000
+#define PLL_SHARED_VCO_KHZ   1500000
+
+static constexpr PllConfig _pllWithVco(uint32_t khz, uint32_t vco_khz) {
+  for (uint32_t pd1 = 7; pd1 >= 1; pd1--) {
+    for (uint32_t pd2 = pd1; pd2 >= 1; pd2--) {
+      if (khz * pd1 * pd2 == vco_khz) return PllConfig{ khz, vco_khz, (uint8_t)pd1, (uint8_t)pd2 };
+    }
+  }
+  return PllConfig{ khz, 0, 0, 0 };
+}
+
+static constexpr PllConfig _pllFor(uint32_t khz) {
+  if (_pllWithVco(khz, PLL_SHARED_VCO_KHZ).vco_khz) return _pllWithVco(khz, PLL_SHARED_VCO_KHZ);
+  for (uint32_t fbdiv = PLL_VCO_MAX_KHZ / PLL_REF_KHZ; fbdiv * PLL_REF_KHZ >= PLL_VCO_MIN_KHZ; fbdiv--) {
+    if (_pllWithVco(khz, fbdiv * PLL_REF_KHZ).vco_khz) return _pllWithVco(khz, fbdiv * PLL_REF_KHZ);
+  }
+  return PllConfig{ khz, 0, 0, 0 };
+}
+
+static constexpr bool _pllTableOk(const PllConfig* tbl, uint8_t n) {
+  for (uint8_t i = 0; i < n; i++) {
+    if (tbl[i].vco_khz == 0) return false;
+  }
+  return true;
+}
+
+static constexpr PllConfig RP2040_PLL[] = {
+  _pllFor(PICOMIMI_RP2040_FREQ[0]), _pllFor(PICOMIMI_RP2040_FREQ[1]), _pllFor(PICOMIMI_RP2040_FREQ[2]),
+  _pllFor(PICOMIMI_RP2040_FREQ[3]), _pllFor(PICOMIMI_RP2040_FREQ[4])
+};
+static constexpr PllConfig RP2350_PLL[] = {
+  _pllFor(PICOMIMI_RP2350_FREQ[0]), _pllFor(PICOMIMI_RP2350_FREQ[1]), _pllFor(PICOMIMI_RP2350_FREQ[2]),
+  _pllFor(PICOMIMI_RP2350_FREQ[3]), _pllFor(PICOMIMI_RP2350_FREQ[4])
+};
+
+static_assert(_pllTableOk(RP2040_PLL, PROFILE_COUNT), "PICOMIMI_RP2040_FREQ has a frequency the PLL can't make");
+static_assert(_pllTableOk(RP2350_PLL, PROFILE_COUNT), "PICOMIMI_RP2350_FREQ has a frequency the PLL can't make");
+
 // ============================================================================
 // LOAD DETECTION THRESHOLDS
 // ============================================================================
 
-// User code time thresholds (microseconds)
-// These determine how we interpret the time spent in user code
-#define IDLE_THRESHOLD_US      100     // < 100us = just loop overhead, no real work
-#define LIGHT_WORK_US          500     // 100-500us = light work
-#define MEDIUM_WORK_US         2000    // 500us-2ms = medium work
-#define HEAVY_WORK_US          10000   // 2-10ms = heavy work
-// > 10ms = either very heavy work OR delays (check idle time)
-
-// Scaling thresholds (load %)
-#define TURBO_UP     70
-#define TURBO_DOWN   55
-#define PERF_UP      45
-#define PERF_DOWN    30
-#define BAL_UP       20
-#define BAL_DOWN     12
-#define SAVE_DOWN    5
-#define ULTRA_DOWN   2
-
-// Timing
-#define LOAD_PERIOD_MS       200
-#define SCALE_INTERVAL_MS    100
-#define TURBO_MAX_MS         10000
-#define BOOST_DURATION_MS    300
-#define THERMAL_THROTTLE     70.0f
-#define THERMAL_CRITICAL     80.0f
-#define THERMAL_RELEASE      60.0f
-#define LOAD_SMOOTH          0.3f
+// Thresholds and timing are in GovernorConfig
+#define THERMAL_TARGET       70.0f   // PID setpoint
+#define THERMAL_CRITICAL     80.0f   // Hard cap to POWERSAVE
+#define THERMAL_LOOKAHEAD_MS 2000    // The hard cap acts on where the slope is heading
+#define TEMP_BURST           7       // Blocking reads per median, TEMP_SAMPLE_SINGLE
+
+#ifndef ADC_TEMPERATURE_CHANNEL_NUM
+#define ADC_TEMPERATURE_CHANNEL_NUM 4
+#endif
+#define ADC_CLOCK_HZ         48000000
+#define ADC_RING_BITS        7           // log2 of the ring in bytes
+#define ADC_DMA_COUNT        0x0FFFFFFF  // Top four bits are the mode field on RP2350
+static_assert((1u << ADC_RING_BITS) == PICOMIMI_ADC_RING * sizeof(uint16_t), "DMA ring wraps on its size");
+static_assert(PICOMIMI_TEMP_SAMPLES >= TEMP_BURST, "burst fits the median buffer");
+#define VREG_SETTLE_MIN_US   5
+#define VREG_SETTLE_MAX_US   150
+
+// Predictive policy
+#define BURST_FACTOR         4       // Iteration is a burst at 4x the typical work
+#define BURST_MIN_US         500     // Shorter iterations are never bursts
+#define PREDICT_JITTER_PCT   12      // Intervals this close to the median are periodic
+#define PREDICT_MIN_HITS     5       // ...and this many of them make a pattern
+#define PREDICT_BURST_SHARE  50      // Burst should fit in this % of its period
+#define PREDICT_LEAD_US      1000    // Raise at least this long before a burst
+
+// Undervolt calibration
+#define CAL_MIN_MV           850     // Lowest voltage tried
+#define CAL_STEP_MV          50      // One vreg step
+#define CAL_TRIAL_MS         100     // Kernel run time per voltage
+#define CAL_WATCHDOG_MS      50      // Hang detection while a trial runs
+#define CAL_SCRATCH_MAGIC    0xCA1B  // Top half of watchdog scratch[0]
+
+// Energy accounting (the current model is in PicomimiPolicy)
+#ifndef PICOMIMI_SUPPLY_MV
+#define PICOMIMI_SUPPLY_MV   3300    // Linear vreg: input current ~ core current
+#endif
+
+// Flash storage: one sector per record, counting down from the top of
+// the sketch area (below the filesystem/EEPROM on arduino-pico)
+#define FLASH_SLOT_CAL       0
+#define FLASH_SLOT_TUNE      1
+
+#ifndef PICOMIMI_FLASH_OFFSET
+extern "C" uint8_t _FS_start;
+#define PICOMIMI_FLASH_OFFSET ((uintptr_t)&_FS_start - XIP_BASE - FLASH_SECTOR_SIZE)
+#endif
+
+// Flash: QSPI divider limits and what counts as a flash-bound window
+#define FLASH_MIN_DIV        2       // Boot2's own setting; SCK = clk_sys / div
+#define XIP_MIN_ACCESSES     1000    // Fewer per window: not running from flash
+#define XIP_SCK_SLACK_PCT    10      // Cap level gets at least this close to the best SCK
+
+// Bus contention: SRAM is striped, so bank 0 stands in for all four
+#define BUS_MIN_ACCESSES     1000    // Fewer per window: too few to judge
+
+// Runs from RAM with interrupts off and the other core parked: nothing
+// may fetch from flash while the QSPI interface is reconfigured. The SSI
+// keeps boot2's RX sample delay, which counts SCK cycles.
+static void __no_inline_not_in_flash_func(_setFlashDiv)(uint32_t div, uint32_t rx) {
+#if PICO_RP2350
+  qmi_hw->m[0].timing = (qmi_hw->m[0].timing & ~(QMI_M0_TIMING_CLKDIV_BITS | QMI_M0_TIMING_RXDELAY_BITS)) |
+                        (div << QMI_M0_TIMING_CLKDIV_LSB) | (rx << QMI_M0_TIMING_RXDELAY_LSB);
+#else
+  (void)rx;
+  while (ssi_hw->sr & SSI_SR_BUSY_BITS) {}
+  ssi_hw->ssienr = 0;
+  ssi_hw->baudr = div;
+  ssi_hw->ssienr = 1;
+#endif
+}
+
+// Deep idle: clk_sys on the crystal (clk_ref's source), pll_sys off
+#define DEEP_LAT_INIT_US     500     // Entry and exit each, until measured
+#define DEEP_MIN_US          5000    // Never for shorter windows, whatever the model says
+
+#ifndef PLL_USB_VCO_FREQ_HZ
+#define PLL_USB_VCO_FREQ_HZ  (480 * MHZ)
+#define PLL_USB_POSTDIV1     5
+#define PLL_USB_POSTDIV2     2
+#endif
+
+// Cross-core mailbox
+enum MailboxOp : uint8_t {
+  MBOX_OPP   = 0,   // setOpp(level, arg = seconds)
+  MBOX_AUTO  = 1,
+  MBOX_BOOST = 2,
+  MBOX_QOS   = 3,   // Aggregate changed, move to it
+  MBOX_POLICY = 4,  // setPolicy(level = policy), custom ops from _ops_stage
+  MBOX_TUNE  = 5,   // setTunables(), from _tune_stage
+  MBOX_DEADLINE = 6, // endTask() missed, re-run the deadline controller
+  MBOX_PHASE = 7    // Phase started or ended, move to level
+};
+
+#define PHASE_UNLEARNED      0xFF
+
+static_assert((PICOMIMI_MAILBOX_SIZE & (PICOMIMI_MAILBOX_SIZE - 1)) == 0 && PICOMIMI_MAILBOX_SIZE <= 128,
+              "PICOMIMI_MAILBOX_SIZE must be a power of two, at most 128");
+
+// Indexed by ScalingPolicy. Predictive's target is only its base clock,
+// the burst raise on top happens in _predict().
+static const PolicyOps BUILTIN_POLICIES[] = {
+  { "ladder",       policyTargetLadder },
+  { "predictive",   policyTargetSched },
+  { "interactive",  policyTargetInteractive },
+  { "conservative", policyTargetConservative },
+  { "ondemand",     policyTargetOndemand },
+  { "schedutil",    policyTargetSched },
+  { "powersave",    policyTargetPowersave },
+  { "performance",  policyTargetPerformance },
+};
+static_assert(sizeof(BUILTIN_POLICIES) / sizeof(BUILTIN_POLICIES[0]) == POLICY_CUSTOM,
+              "one built-in per ScalingPolicy");
 
 // ============================================================================
 // GLOBAL
 // ============================================================================
 
-PicomimiGovernorClass PicomimiGov;
+PicomimiGovernor<> PicomimiGov;
+PicomimiGovernorClass* PicomimiGovernorClass::_timer_gov = nullptr;
+PicomimiGovernorClass* PicomimiGovernorClass::_core1_gov = nullptr;
 
 // ============================================================================
 // CONSTRUCTOR
 // ============================================================================
 
-PicomimiGovernorClass::PicomimiGovernorClass() :
-  _init(false), _manual(false), _chip(PICOMIMI_RP2040),
-  _profile(PROFILE_BALANCED), _freq_khz(133000), _temp(25.0f),
-  _last_run_us(0), _run_start_us(0), _total_loop_time_us(0),
-  _total_idle_time_us(0), _period_start_us(0),
-  _avg_load(0), _instant_load(0), _last_scale_ms(0),
+PicomimiGovernorClass::PicomimiGovernorClass() : PicomimiGovernorClass(governorTunables<GovernorConfig>()) {}
+
+PicomimiGovernorClass::PicomimiGovernorClass(const GovernorTunables& tunables) :
+  _cfg(tunables), _init(false), _manual(false), _chip(PICOMIMI_RP2040),
+  _level(PROFILE_BALANCED), _freq_khz(133000), _temp(25.0f),
+  _owner_core(0), _period_start_us(0),
+  _avg_load(0), _instant_load(0), _load_mix(LOAD_MIX_MAX),
+  _core1_weight(50), _idle_mode(IDLE_SPIN), _min_sleep_us(20),
+  _downclock_ms(0), _wake_lat_us(0), _wake_lat_max_us(0),
+  _deep_entry_us(DEEP_LAT_INIT_US), _deep_exit_us(DEEP_LAT_INIT_US), _deep_count(0), _stall_last_us(0),
+  _stall_max_us(0), _vreg_settle_us(0), _transitions(0),
+  _peri_clock(PERI_CLOCK_FOLLOW_SYS), _service_mode(SERVICE_LOOP), _decision_due(false), _busy(false), _wfi_ok(false),
+  _policy(POLICY_LADDER), _base_level(PROFILE_BALANCED), _pred_raised(false),
+  _pred_dirty(false), _pred_next_us(0), _ops(&BUILTIN_POLICIES[POLICY_LADDER]),
+  _deadline_us(0), _deadline_margin(10), _task_manual(false), _task_start_us(0),
+  _task_us(0), _task_head(0), _task_count(0), _deadline_misses(0),
   _turbo_start_ms(0), _boost_start_ms(0), _override_end_ms(0),
   _turbo_on(false), _throttled(false), _boost_on(false),
-  _override_on(false), _override_profile(PROFILE_BALANCED),
-  _adc_init(false), _first_run(true), _freq_tbl(nullptr),
-  _volt_tbl(nullptr), _cmd("")
+  _override_on(false), _override_expired(false), _override_level(PROFILE_BALANCED),
+  _adc_init(false), _opp_count(0), _custom_count(0), _calibrated(false), _state_since_us(0), _current_scale(1.0f), _trace_head(0), _trace_count(0), _trace_seq(0), _cmd_len(0), _cmd_overflow(false)
 {
+  memset(_cores, 0, sizeof(_cores));
+  memset(_opps, 0, sizeof(_opps));
+  memset(_alias, 0, sizeof(_alias));
+  memset(_task_cycles, 0, sizeof(_task_cycles));
+  memset(_hooks, 0, sizeof(_hooks));
+  memset(_hook_ctx, 0, sizeof(_hook_ctx));
+  memset(_stats, 0, sizeof(_stats));
+  memset(_qos, 0, sizeof(_qos));
+  _qos_floor_khz = 0;
+  _qos_ceil_khz = 0;
+  _qos_next_expiry_ms = 0;
+  _qos_floor = 0;
+  _qos_ceil = PICOMIMI_MAX_OPPS - 1;
+  _lock = nullptr;
+  _ops_stage = nullptr;
+  _tick_ms = 0;
+  _core1_ready = false;
+  _flash_depth = 0;
+  memset(_mbox, 0, sizeof(_mbox));
+  _mbox_pending = false;
+  _mbox_dropped = 0;
+  _snap_seq = 0;
+  _publish();
+  policyPidInit(_pid, THERMAL_TARGET);
+  _cap_level = 0;
+  _tick_pool = nullptr;
+  _decide_irq = -1;
+  _temp_mode = TEMP_SAMPLE_SINGLE;
+  memset(&_temp_filter, 0, sizeof(_temp_filter));
+  _temp_mc = 25000;
+  _temp_slope_mc = 0;
+  _temp_reconfig = false;
+  _temp_reading = false;
+  _adc_dma = -1;
+  _adc_count = 0;
+  _adc_inputs = 0;
+  _adc_rate_hz = 1000;
+  _tm_out = nullptr;
+  _tm_cb = nullptr;
+  _tm_ctx = nullptr;
+  _tm_period_ms = 0;
+  _tm_next_ms = 0;
+  _tm_seq = 0;
+  memset(_tm_res_us, 0, sizeof(_tm_res_us));
+  _throttle_count = 0;
+  _flash_max_khz = 0;
+  _flash_div = FLASH_MIN_DIV;
+  _flash_rx = 0;
+  _flash_rx0 = 0;
+  _flash_rx0_khz = 0;
+  _xip_limit = 0;
+  _xip_cap = 0;
+  _xip_bound = false;
+  _xip_hit = 0;
+  _xip_acc = 0;
+  _bus_min_eff = 0;
+  _bus_eff = 100;
+  memset(&_pstate, 0, sizeof(_pstate));
+  memset(_phases, 0, sizeof(_phases));
+  _phaseClear();
+  _phase_depth = 0;
+  _phase_pin = 0;
 }
 
 // ============================================================================
 // PUBLIC API
 // ============================================================================
 
-void PicomimiGovernorClass::begin(PicomimiChip chip, bool manual) {
+void PicomimiGovernorClass::begin(PicomimiChip chip, bool manual, GovernorService service) {
   _chip = chip;
   _manual = manual;
+  _service_mode = service;
+  if (!_lock) _lock = spin_lock_instance(spin_lock_claim_unused(true));
+  _loadTunables();
   _setupTables();
+  _loadCalibration();
   
-  adc_init();
-  adc_set_temp_sensor_enabled(true);
-  _adc_init = true;
+  if (!_adc_init) {
+    adc_init();
+    adc_set_temp_sensor_enabled(true);
+    _adc_init = true;
+  }
   
-  _profile = PROFILE_BALANCED;
-  _freq_khz = _freq_tbl[PROFILE_BALANCED];
+  // Start from whatever the core booted at and move to BALANCED
+  _freq_khz = clock_get_hz(clk_sys) / 1000;
+  _level = _nearestLevel(_freq_khz);
+  _cap_level = _opp_count - 1;
+  _qosLevels();
+#if PICO_RP2350
+  _flash_div = (qmi_hw->m[0].timing & QMI_M0_TIMING_CLKDIV_BITS) >> QMI_M0_TIMING_CLKDIV_LSB;
+  _flash_rx0 = (qmi_hw->m[0].timing & QMI_M0_TIMING_RXDELAY_BITS) >> QMI_M0_TIMING_RXDELAY_LSB;
+  _flash_rx0_khz = _freq_khz;
+  _flash_rx = _flash_rx0;
+#else
+  _flash_div = ssi_hw->baudr;
+#endif
+  _xipCapUpdate();
+  _retuneFlash();
+  xip_ctrl_hw->ctr_hit = 0;
+  xip_ctrl_hw->ctr_acc = 0;
+  policyPidReset(_pid, _table[_cap_level].khz);
+  _state_since_us = time_us_64();
+  _apply(_alias[PROFILE_BALANCED], TRACE_START);
+  if (_calibrated) vreg_set_voltage(_toVreg(_table[_level].mv));
   
   uint64_t now = time_us_64();
-  _last_run_us = now;
-  _run_start_us = now;
+  for (uint8_t i = 0; i < PICOMIMI_NUM_CORES; i++) {
+    CoreLoad& c = _cores[i];
+    memset(&c, 0, sizeof(c));
+    c.first_run = true;
+    c.last_run_us = (uint32_t)now;
+  }
+  _armSampler(get_core_num());
+  _base_level = _level;
+  _pred_raised = false;
+  _pred_dirty = true;
+  _owner_core = _service_mode == SERVICE_CORE1 ? 1 : get_core_num();
   _period_start_us = now;
-  _total_loop_time_us = 0;
-  _total_idle_time_us = 0;
-  _first_run = true;
-  _last_scale_ms = to_ms_since_boot(get_absolute_time());
+  
+  // Without run() nothing else marks the scaling core as running
+  if (_service_mode == SERVICE_TIMER) _cores[_owner_core].active = true;
   
   _init = true;
+  _publish();
+  
+  _decision_due = false;
+  if (_service_mode == SERVICE_CORE1) {
+    multicore_lockout_victim_init();    // Core1 parks this core for flash writes
+    _core1_gov = this;
+    multicore_launch_core1(_core1Entry);
+    while (!_core1_ready) tight_loop_contents();
+  } else {
+    if (_service_mode == SERVICE_TIMER) _armDecideIrq();
+    _armTick();
+  }
   
   if (_manual) {
     Serial.println(F("\n╔══════════════════════════════════════════╗"));
@@ -114,368 +389,2941 @@ void PicomimiGovernorClass::begin(PicomimiChip chip, bool manual) {
     Serial.println(F("╚══════════════════════════════════════════╝"));
     Serial.print(F("Chip: "));
     Serial.println(_chip == PICOMIMI_RP2350 ? "RP2350" : "RP2040");
+    if (_custom_count > 0) {
+      Serial.print(F("Operating points: ")); Serial.println(_opp_count);
+    }
+    if (_calibrated) Serial.println(F("Voltage curve: calibrated"));
+    if (_service_mode == SERVICE_CORE1) {
+      Serial.println(F("[GOV] Core1 is the governor's: wrap EEPROM.commit()/LittleFS writes in beginFlashWrite()/endFlashWrite()"));
+    }
+    if (getIdleSource(get_core_num()) == IDLE_SOURCE_DECLARED) {
+      Serial.println(F("[GOV] No idle sampler: delay() counts as load, use PicomimiGov.idle()"));
+    }
     Serial.println(F("Type 'gov' for commands.\n"));
   }
 }
 
+// Fast path: one 32-bit timer read and the accounting. Everything else
+// waits until the tick alarm says a decision is due.
 void PicomimiGovernorClass::run() {
   if (!_init) return;
   
-  uint64_t now_us = time_us_64();
+  uint32_t now = time_us_32();
+  uint8_t core_num = get_core_num();
+  CoreLoad& core = _cores[core_num];
+  _account(core, now);
   
-  // Measure user code time (time since last run() completed)
-  if (!_first_run) {
-    uint64_t user_code_time = now_us - _last_run_us;
-    
-    // Subtract any explicitly marked idle time
-    uint64_t work_time = (user_code_time > _total_idle_time_us) 
-                         ? (user_code_time - _total_idle_time_us) 
-                         : 0;
-    
-    _total_loop_time_us += work_time;
+  // Only the core that called begin() makes scaling decisions;
+  // the other core just feeds its counters.
+  if (core_num == _owner_core) {
+    if (_mbox_pending && _service_mode == SERVICE_LOOP) _drain();
+    if (_decision_due) {
+      _service();
+      now = time_us_32();
+    }
+    // Nothing to predict between window edges unless a burst moved them
+    if (_policy == POLICY_PREDICTIVE && !_override_on && _deadline_us == 0 &&
+        (_pred_dirty || (int32_t)(now - _pred_next_us) >= 0)) {
+      if (_predict(now)) now = time_us_32();
+    }
+    if (_wfi_ok) {
+      _wfi();
+      now = time_us_32();
+    }
   }
-  _first_run = false;
-  
-  // Reset idle accumulator for next iteration
-  _total_idle_time_us = 0;
-  
-  uint32_t now_ms = to_ms_since_boot(get_absolute_time());
   
+  core.last_run_us = now;
+}
+
+// Slow path, once per scale interval
+void PicomimiGovernorClass::_service() {
+  _decision_due = false;
+  if (_service_mode != SERVICE_TIMER) _decide();
+  if (_override_expired) {
+    _override_expired = false;
+    if (_manual) Serial.println(F("[GOV] Override expired"));
+  }
+  if (_manual) _handleSerial();
+  // In SERVICE_TIMER a callback sink is fed from _onDecide() instead
+  if (_tm_period_ms && (_tm_out || _service_mode != SERVICE_TIMER)) _telemetry();
+}
+
+void PicomimiGovernorClass::_decide() {
   _updateLoad();
+  _sampleTemp();
+  _decideLevel();
+}
+
+// Everything that can change the level. No printing: in SERVICE_TIMER
+// this runs in an interrupt.
+void PicomimiGovernorClass::_decideLevel() {
+  _thermal();
+  _timeouts();
+  if (!_override_on) _scale();
   
-  if (now_ms - _last_scale_ms >= SCALE_INTERVAL_MS) {
-    _thermal();
-    _timeouts();
-    if (!_override_on) _scale();
-    _last_scale_ms = now_ms;
-  }
+  _wfi_ok = _chip == PICOMIMI_RP2350 && _level == 0 &&
+            _avg_load < PICOMIMI_LOAD_Q16(_cfg.ultra_down) && !_throttled;
+  _publish();
+}
+
+// Negative delay: fixed rate, not fixed gap between callbacks. The alarm
+// fires on the core that owns the pool, so a core other than core0 gets
+// a pool of its own.
+void PicomimiGovernorClass::_armTick() {
+  _tick_ms = _cfg.scale_interval_ms;
+  if (_tick_pool) alarm_pool_add_repeating_timer_ms(_tick_pool, -(int32_t)_tick_ms, _onTick, this, &_tick_timer);
+  else add_repeating_timer_ms(-(int32_t)_tick_ms, _onTick, this, &_tick_timer);
+}
+
+void PicomimiGovernorClass::_core1Entry() { _core1_gov->_core1Loop(); }
+
+// SERVICE_CORE1: everything the owner core does in run(), in thread
+// context on core1. The tick IRQ or a post's __sev() ends each WFE;
+// an event that lands between the checks and the WFE is latched, so
+// nothing is missed.
+void PicomimiGovernorClass::_core1Loop() {
+  multicore_lockout_victim_init();      // Core0 parks this core for flash writes
+  _tick_pool = alarm_pool_create_with_unused_hardware_alarm(4);
+  _armTick();
+  _core1_ready = true;
   
-  if (_chip == PICOMIMI_RP2350 && _profile == PROFILE_ULTRA_LOW && 
-      _avg_load < ULTRA_DOWN && !_throttled) {
-    _wfi();
+  while (true) {
+    if (_mbox_pending) _drain();
+    if (_decision_due) _service();
+    __wfe();
   }
-  
-  if (_manual) _handleSerial();
-  
-  _last_run_us = time_us_64();
 }
 
+// Scaling tick. In SERVICE_TIMER only the load sample is taken here;
+// the ADC reads and the PLL and voltage waits of a level change run in
+// _onDecide(), which any other interrupt can preempt.
+bool PicomimiGovernorClass::_onTick(repeating_timer_t* rt) {
+  PicomimiGovernorClass* gov = (PicomimiGovernorClass*)rt->user_data;
+  if (gov->_service_mode == SERVICE_TIMER) {
+    gov->_updateLoad();
+    irq_set_pending(gov->_decide_irq);
+  }
+  gov->_decision_due = true;
+  return true;
+}
+
+// SERVICE_TIMER decisions, at the lowest priority on the owner core.
+// Skips a beat if the main context is mid level change.
+void PicomimiGovernorClass::_onDecide() {
+  PicomimiGovernorClass* gov = _timer_gov;
+  if (gov->_busy) return;
+  if (gov->_mbox_pending) gov->_drain();
+  gov->_sampleTemp();
+  gov->_decideLevel();
+  if (gov->_tm_period_ms && gov->_tm_cb) gov->_telemetry();
+}
+
+// The spare IRQ is enabled on this core only, and the tick has to pend it
+// from here too, so a core other than core0 gets an alarm pool of its own
+void PicomimiGovernorClass::_armDecideIrq() {
+  if (_decide_irq < 0) {
+    _decide_irq = (int8_t)user_irq_claim_unused(true);
+    irq_set_exclusive_handler(_decide_irq, _onDecide);
+    irq_set_priority(_decide_irq, PICO_LOWEST_IRQ_PRIORITY);
+  }
+  _timer_gov = this;
+  irq_set_enabled(_decide_irq, true);
+  if (get_core_num() != 0 && !_tick_pool) _tick_pool = alarm_pool_create_with_unused_hardware_alarm(4);
+}
+
+// Idle counters are 32-bit: a long idle() pins them at the top
+static inline void _addSat(volatile uint32_t& acc, uint64_t us) {
+  uint64_t sum = acc + us;
+  acc = sum > UINT32_MAX ? UINT32_MAX : (uint32_t)sum;
+}
+
+// IDLE_SPIN counts the requested time as idle; IDLE_SLEEP counts what
+// it actually spent asleep, so ISRs that wake it count as work
 void PicomimiGovernorClass::idle(uint32_t ms) {
-  _total_idle_time_us += (uint64_t)ms * 1000ULL;
-  delay(ms);
+  CoreLoad& c = _cores[get_core_num()];
+  uint64_t us = (uint64_t)ms * 1000;
+  _addSat(c.idle_us, us);
+  if (_idle_mode == IDLE_SPIN) {
+    _idleBegin(c);
+    delay(ms);
+    _idleEnd(c, us);
+  } else _idleFor(us);
 }
 
 void PicomimiGovernorClass::idleMicros(uint32_t us) {
-  _total_idle_time_us += us;
-  delayMicroseconds(us);
+  CoreLoad& c = _cores[get_core_num()];
+  _addSat(c.idle_us, us);
+  if (_idle_mode == IDLE_SPIN) {
+    _idleBegin(c);
+    delayMicroseconds(us);
+    _idleEnd(c, us);
+  } else _idleFor(us);
 }
 
 void PicomimiGovernorClass::inputBoost() {
-  if (!_init || _throttled) return;
+  if (!_init) return;
+  if (_direct()) _doBoost();
+  else _post(MBOX_BOOST, 0, 0);
+}
+
+void PicomimiGovernorClass::_doBoost() {
   _boost_start_ms = to_ms_since_boot(get_absolute_time());
   _boost_on = true;
-  if (_profile < PROFILE_PERFORMANCE) _apply(PROFILE_PERFORMANCE);
+  uint8_t target = _capLevel(_alias[PROFILE_PERFORMANCE]);
+  if (_level < target) _apply(target, TRACE_BOOST);
 }
 
 // ============================================================================
 // STATUS
 // ============================================================================
 
-uint32_t PicomimiGovernorClass::getFreqMHz() { return _freq_khz / 1000; }
-float PicomimiGovernorClass::getCPULoad() { return _avg_load; }
-float PicomimiGovernorClass::getTemperature() { return _temp; }
-PowerProfile PicomimiGovernorClass::getProfile() { return _profile; }
-const char* PicomimiGovernorClass::getProfileName() { return PROFILE_NAMES[_profile]; }
-bool PicomimiGovernorClass::isTurbo() { return _turbo_on; }
-bool PicomimiGovernorClass::isThrottled() { return _throttled; }
+// Readers pick the slot the sequence number points at; the writer only
+// touches the other one, so a changed sequence means retry
+void PicomimiGovernorClass::getStatus(GovernorStatus& out) {
+  uint32_t seq;
+  do {
+    seq = _snap_seq;
+    __dmb();
+    out = _snap[seq & 1];
+    __dmb();
+  } while (seq != _snap_seq);
+}
+
+uint32_t PicomimiGovernorClass::getDroppedCommands() { return _mbox_dropped; }
+
+uint32_t PicomimiGovernorClass::getFreqMHz() {
+  GovernorStatus s;
+  getStatus(s);
+  return s.freq_khz / 1000;
+}
+
+float PicomimiGovernorClass::getCPULoad() {
+  GovernorStatus s;
+  getStatus(s);
+  return s.avg_load / 65536.0f;
+}
+
+float PicomimiGovernorClass::getCPULoad(uint8_t core) {
+  if (core >= PICOMIMI_NUM_CORES) return 0.0f;
+  GovernorStatus s;
+  getStatus(s);
+  return s.core_load[core] / 65536.0f;
+}
+
+float PicomimiGovernorClass::getTemperature() {
+  GovernorStatus s;
+  getStatus(s);
+  return s.temp_mc / 1000.0f;
+}
+
+float PicomimiGovernorClass::getTemperatureSlope() { return _temp_slope_mc / 1000.0f; }
+PowerProfile PicomimiGovernorClass::getProfile() {
+  GovernorStatus s;
+  getStatus(s);
+  return (PowerProfile)s.profile;
+}
+
+const char* PicomimiGovernorClass::getProfileName() { return PROFILE_NAMES[getProfile()]; }
+
+bool PicomimiGovernorClass::isTurbo() {
+  GovernorStatus s;
+  getStatus(s);
+  return s.turbo;
+}
+
+bool PicomimiGovernorClass::isThrottled() {
+  GovernorStatus s;
+  getStatus(s);
+  return s.throttled;
+}
+
+uint32_t PicomimiGovernorClass::getFreqCapMHz() {
+  GovernorStatus s;
+  getStatus(s);
+  return s.cap_khz / 1000;
+}
 
 // ============================================================================
 // MANUAL CONTROL
 // ============================================================================
 
-void PicomimiGovernorClass::setProfile(PowerProfile p, uint32_t duration_sec) {
-  if (p >= PROFILE_COUNT) return;
+void PicomimiGovernorClass::setOpp(uint8_t level, uint32_t duration_sec) {
+  if (level >= _opp_count) return;
+  if (_direct()) _doOpp(level, duration_sec);
+  else _post(MBOX_OPP, level, duration_sec);
+}
+
+void PicomimiGovernorClass::_doOpp(uint8_t level, uint32_t duration_sec) {
   _override_on = true;
-  _override_profile = p;
+  _override_level = level;
   _override_end_ms = duration_sec > 0 
     ? to_ms_since_boot(get_absolute_time()) + (duration_sec * 1000) : 0;
-  _apply(p);
+  _apply(level, TRACE_OVERRIDE);
+}
+
+void PicomimiGovernorClass::setProfile(PowerProfile p, uint32_t duration_sec) {
+  if (p >= PROFILE_COUNT) return;
+  setOpp(_alias[p], duration_sec);
 }
 
 void PicomimiGovernorClass::setTurbo(uint32_t s) { setProfile(PROFILE_TURBO, s); }
 void PicomimiGovernorClass::setPowersave(uint32_t s) { setProfile(PROFILE_POWERSAVE, s); }
-void PicomimiGovernorClass::setAuto() { _override_on = false; _override_end_ms = 0; }
+void PicomimiGovernorClass::setAuto() {
+  if (_direct()) { _override_on = false; _override_end_ms = 0; }
+  else _post(MBOX_AUTO, 0, 0);
+}
 
 // ============================================================================
-// INTERNAL - Setup
+// QOS REQUESTS
 // ============================================================================
 
-void PicomimiGovernorClass::_setupTables() {
-  _freq_tbl = (_chip == PICOMIMI_RP2350) ? RP2350_FREQ : RP2040_FREQ;
-  _volt_tbl = (_chip == PICOMIMI_RP2350) ? RP2350_VOLT : RP2040_VOLT;
+int PicomimiGovernorClass::addMinFreqRequest(uint32_t mhz, uint32_t timeout_ms) {
+  return _addRequest(mhz, timeout_ms, false);
 }
 
-// ============================================================================
-// INTERNAL - Load Calculation
-// ============================================================================
+int PicomimiGovernorClass::addMaxFreqRequest(uint32_t mhz, uint32_t timeout_ms) {
+  return _addRequest(mhz, timeout_ms, true);
+}
 
-void PicomimiGovernorClass::_updateLoad() {
-  uint64_t now_us = time_us_64();
-  uint64_t period_elapsed = now_us - _period_start_us;
-  
-  if (period_elapsed < (LOAD_PERIOD_MS * 1000ULL)) return;
+// The slot is filled in the same critical section that claims it, so an
+// aggregate in between never sees a used slot with stale khz/expiry
+int PicomimiGovernorClass::_addRequest(uint32_t mhz, uint32_t timeout_ms, bool ceiling) {
+  int handle = -1;
+  uint32_t now = to_ms_since_boot(get_absolute_time());
+  uint32_t irq = _lockQos();
+  for (uint8_t i = 0; i < PICOMIMI_MAX_QOS; i++) {
+    QosSlot& q = _qos[i];
+    if (q.used) continue;
+    q.ceiling = ceiling;
+    q.khz = mhz * 1000;
+    q.expires_ms = timeout_ms ? (now + timeout_ms) | 1 : 0;
+    q.used = true;
+    handle = i;
+    _qosAggregate(now);
+    break;
+  }
+  _unlockQos(irq);
   
-  // Calculate average work time per loop
-  // total_loop_time_us = sum of (user_code_time - idle_time) over the period
+  if (handle >= 0) _qosApply();
+  return handle;
+}
+
+bool PicomimiGovernorClass::updateRequest(int handle, uint32_t mhz, uint32_t timeout_ms) {
+  if (handle < 0 || handle >= PICOMIMI_MAX_QOS || !_qos[handle].used) return false;
+  uint32_t now = to_ms_since_boot(get_absolute_time());
   
-  // Estimate number of loops (rough)
-  // This isn't perfect but gives us average work per iteration
-  uint64_t avg_work_per_loop;
+  uint32_t irq = _lockQos();
+  _qos[handle].khz = mhz * 1000;
+  _qos[handle].expires_ms = timeout_ms ? (now + timeout_ms) | 1 : 0;
+  _qosAggregate(now);
+  _unlockQos(irq);
   
-  if (_total_loop_time_us < IDLE_THRESHOLD_US * 10) {
-    // Very little total work - basically idle
-    _instant_load = 0.0f;
-  } else {
-    // Calculate load based on how much work time accumulated
-    // Compare against period time
-    // load = work_time / period_time * 100, but capped
-    
-    float work_ratio = (float)_total_loop_time_us / (float)period_elapsed;
-    
-    // Apply work-time-based scaling
-    // The idea: if work_ratio is high AND work time is substantial, it's real load
-    // If work_ratio is high but absolute work time is tiny, it's just tight spinning
-    
-    // Average work per loop iteration
-    // Assume ~1000 loops per 200ms period at minimum (tight loop)
-    // If total work is < 100ms over 200ms, we're doing real work
-    // If total work is close to 200ms, we're in a tight compute loop
-    
-    if (_total_loop_time_us < 1000) {
-      // Less than 1ms total work in 200ms = essentially idle
-      _instant_load = 0.0f;
-    } else if (_total_loop_time_us < 10000) {
-      // 1-10ms total work in 200ms = very light load (0.5-5%)
-      _instant_load = ((float)_total_loop_time_us / (float)period_elapsed) * 100.0f;
-    } else if (_total_loop_time_us < 50000) {
-      // 10-50ms total work = light load (5-25%)
-      _instant_load = ((float)_total_loop_time_us / (float)period_elapsed) * 100.0f;
-    } else if (_total_loop_time_us < 100000) {
-      // 50-100ms total work = medium load (25-50%)
-      _instant_load = ((float)_total_loop_time_us / (float)period_elapsed) * 100.0f;
-    } else {
-      // 100ms+ total work = high load
-      _instant_load = ((float)_total_loop_time_us / (float)period_elapsed) * 100.0f;
+  _qosApply();
+  return true;
+}
+
+void PicomimiGovernorClass::removeRequest(int handle) {
+  if (handle < 0 || handle >= PICOMIMI_MAX_QOS) return;
+  uint32_t irq = _lockQos();
+  _qos[handle].used = false;
+  _qosAggregate(to_ms_since_boot(get_absolute_time()));
+  _unlockQos(irq);
+  _qosApply();
+}
+
+uint32_t PicomimiGovernorClass::getMinFreqMHz() { return _qos_floor_khz / 1000; }
+uint32_t PicomimiGovernorClass::getMaxFreqMHz() { return _qos_ceil_khz / 1000; }
+
+// Runs only when a request changes or times out, so _scale() just reads
+// two levels. Expired slots are freed here.
+void PicomimiGovernorClass::_qosAggregate(uint32_t now_ms) {
+  uint32_t floor_khz = 0, ceil_khz = 0, next = 0;
+  for (uint8_t i = 0; i < PICOMIMI_MAX_QOS; i++) {
+    QosSlot& q = _qos[i];
+    if (!q.used) continue;
+    if (q.expires_ms && (int32_t)(now_ms - q.expires_ms) >= 0) {
+      q.used = false;
+      continue;
     }
+    if (q.ceiling) {
+      if (ceil_khz == 0 || q.khz < ceil_khz) ceil_khz = q.khz;
+    } else if (q.khz > floor_khz) floor_khz = q.khz;
+    if (q.expires_ms && (next == 0 || (int32_t)(q.expires_ms - next) < 0)) next = q.expires_ms;
   }
-  
-  // Clamp
-  if (_instant_load < 0) _instant_load = 0;
-  if (_instant_load > 100) _instant_load = 100;
-  
-  // Smooth
-  _avg_load = (_avg_load * (1.0f - LOAD_SMOOTH)) + (_instant_load * LOAD_SMOOTH);
-  
-  // Reset
-  _period_start_us = now_us;
-  _total_loop_time_us = 0;
+  _qos_floor_khz = floor_khz;
+  _qos_ceil_khz = ceil_khz;
+  _qos_next_expiry_ms = next;
+  _qosLevels();
+}
+
+void PicomimiGovernorClass::_qosLevels() {
+  if (_opp_count == 0) return;
+  _qos_floor = _qos_floor_khz ? policyAtLeast(_table, _opp_count, _qos_floor_khz) : 0;
+  _qos_ceil = _qos_ceil_khz ? policyAtMost(_table, _opp_count, _qos_ceil_khz) : _opp_count - 1;
+}
+
+// Move now rather than at the next tick; a pinned level stays pinned
+void PicomimiGovernorClass::_qosApply() {
+  if (!_init) return;
+  if (_direct()) _qosMove();
+  else _post(MBOX_QOS, 0, 0);
+}
+
+void PicomimiGovernorClass::_qosMove() {
+  if (_override_on) return;
+  uint8_t target = _capLevel(_level);
+  if (target != _level) _apply(target, TRACE_QOS);
 }
 
 // ============================================================================
-// INTERNAL - Scaling
+// PHASE HINTS
 // ============================================================================
 
-void PicomimiGovernorClass::_scale() {
-  if (_boost_on && _profile >= PROFILE_PERFORMANCE) return;
-  
-  PowerProfile target = _profile;
-  float load = _avg_load;
-  bool can_up = !_throttled;
+int PicomimiGovernorClass::hint(uint8_t phase) {
+  if (!_init || phase >= PICOMIMI_MAX_PHASES) return -1;
   
-  if (can_up) {
-    if (load >= TURBO_UP && _profile < PROFILE_TURBO) target = PROFILE_TURBO;
-    else if (load >= PERF_UP && _profile < PROFILE_PERFORMANCE) target = PROFILE_PERFORMANCE;
-    else if (load >= BAL_UP && _profile < PROFILE_BALANCED) target = PROFILE_BALANCED;
+  uint32_t irq = _lockQos();
+  uint8_t token = _phase_depth;
+  if (token >= PICOMIMI_PHASE_DEPTH) {
+    _unlockQos(irq);
+    return -1;
   }
+  PhaseFrame& f = _phase_stack[token];
+  f.phase = phase;
+  f.pin = _phaseTarget(phase);
+  f.prev_level = _level;
+  f.start_us = time_us_32();
+  _phase_pin = f.pin;
+  _phase_depth = token + 1;
+  _unlockQos(irq);
   
-  if (_profile == PROFILE_TURBO && load < TURBO_DOWN) target = PROFILE_PERFORMANCE;
-  else if (_profile == PROFILE_PERFORMANCE && load < PERF_DOWN) target = PROFILE_BALANCED;
-  else if (_profile == PROFILE_BALANCED && load < BAL_DOWN) target = PROFILE_POWERSAVE;
-  else if (_profile == PROFILE_POWERSAVE && load < SAVE_DOWN) target = PROFILE_ULTRA_LOW;
+  _phaseApply(f.pin);
+  return token;
+}
+
+// A stale token (its frame already ended by an outer one) does nothing
+void PicomimiGovernorClass::hintEnd(int token) {
+  if (token < 0) return;
+  uint32_t now = time_us_32();
   
-  if (_throttled && target > PROFILE_BALANCED) target = PROFILE_BALANCED;
+  uint32_t irq = _lockQos();
+  if (token >= _phase_depth) {
+    _unlockQos(irq);
+    return;
+  }
+  uint8_t restore = _phase_stack[token].prev_level;
+  while (_phase_depth > token) {
+    const PhaseFrame& f = _phase_stack[_phase_depth - 1];
+    _phaseLearn(f, now - f.start_us);
+    _phase_depth = _phase_depth - 1;
+  }
+  if (_phase_depth) _phase_pin = _phase_stack[_phase_depth - 1].pin;
+  _unlockQos(irq);
   
-  if (target != _profile) _apply(target);
+  _phaseApply(restore);
 }
 
-void PicomimiGovernorClass::_apply(PowerProfile p) {
-  if (p >= PROFILE_COUNT) return;
-  _setFreq(_freq_tbl[p], _volt_tbl[p]);
-  _profile = p;
-  
-  if (p == PROFILE_TURBO && !_turbo_on) {
-    _turbo_start_ms = to_ms_since_boot(get_absolute_time());
-    _turbo_on = true;
-  } else if (p != PROFILE_TURBO) {
-    _turbo_on = false;
+void PicomimiGovernorClass::setPhaseBudget(uint8_t phase, uint32_t us) {
+  if (phase >= PICOMIMI_MAX_PHASES) return;
+  uint32_t irq = _lockQos();
+  _phases[phase].budget_us = us;
+  _phases[phase].stats.settled = false;   // Re-probe against the new limit
+  _unlockQos(irq);
+}
+
+bool PicomimiGovernorClass::getPhaseStats(uint8_t phase, PhaseStats& out) {
+  if (phase >= PICOMIMI_MAX_PHASES) return false;
+  uint32_t irq = _lockQos();
+  out = _phases[phase].stats;
+  _unlockQos(irq);
+  return out.count > 0;
+}
+
+void PicomimiGovernorClass::resetPhases() {
+  uint32_t irq = _lockQos();
+  _phaseClear();
+  _unlockQos(irq);
+}
+
+// Learning only; budgets set by the application stay
+void PicomimiGovernorClass::_phaseClear() {
+  for (uint8_t i = 0; i < PICOMIMI_MAX_PHASES; i++) {
+    uint32_t budget = _phases[i].budget_us;
+    memset(&_phases[i], 0, sizeof(_phases[i]));
+    _phases[i].budget_us = budget;
+    _phases[i].level = PHASE_UNLEARNED;
   }
 }
 
-void PicomimiGovernorClass::_setFreq(uint32_t khz, uint32_t mv) {
-  vreg_voltage vr = _toVreg(mv);
-  
-  if (khz > _freq_khz) {
-    vreg_set_voltage(vr);
-    busy_wait_us(150);
+// Learned level, or one below it while still probing
+uint8_t PicomimiGovernorClass::_phaseTarget(uint8_t phase) {
+  const PhaseSlot& p = _phases[phase];
+  if (p.level == PHASE_UNLEARNED) {
+    switch (phase) {
+      case PHASE_IDLE: return 0;
+      case PHASE_UI:   return _alias[PROFILE_PERFORMANCE];
+      case PHASE_IO:   return _alias[PROFILE_BALANCED];
+      default:         return _opp_count - 1;
+    }
   }
+  return (!p.stats.settled && p.level > 0) ? p.level - 1 : p.level;
+}
+
+// A probe that kept within the limit becomes the level; one that didn't
+// settles the phase where it was. A settled phase that slows down steps
+// back up, and at the top the slower run becomes the new reference.
+void PicomimiGovernorClass::_phaseLearn(const PhaseFrame& f, uint32_t us) {
+  PhaseSlot& p = _phases[f.phase];
+  PhaseStats& s = p.stats;
+  s.count++;
+  s.last_us = us;
+  s.total_us += us;
+  s.total_cycles += (uint64_t)us * _freq_khz / 1000;
   
-  if (!set_sys_clock_khz(khz, true)) {
-    set_sys_clock_khz(133000, true);
-    _freq_khz = 133000;
-    return;
+  uint8_t top = _opp_count - 1;
+  if (p.level == PHASE_UNLEARNED) {
+    p.level = f.pin;
+    s.best_us = us;
+  } else {
+    uint32_t limit = p.budget_us ? p.budget_us
+                   : (uint32_t)((uint64_t)s.best_us * (100 + PICOMIMI_PHASE_SLACK_PCT) / 100);
+    if (us <= limit) {
+      if (f.pin < p.level) p.level = f.pin;
+      if (us < s.best_us) s.best_us = us;
+    } else if (f.pin < p.level) {
+      s.settled = true;
+    } else if (p.level < top) {
+      p.level++;
+      s.settled = true;
+    } else {
+      s.best_us = us;
+    }
   }
-  
-  if (khz < _freq_khz) vreg_set_voltage(vr);
-  _freq_khz = khz;
+  s.learned_khz = _table[p.level].khz;
 }
 
-// ============================================================================
-// INTERNAL - Thermal
-// ============================================================================
+void PicomimiGovernorClass::_phaseApply(uint8_t level) {
+  if (_direct()) _phaseMove(level);
+  else _post(MBOX_PHASE, level, 0);
+}
 
-void PicomimiGovernorClass::_thermal() {
-  adc_select_input(4);
-  uint16_t raw = adc_read();
-  _temp = 27.0f - (raw * (3.3f / 4096.0f) - 0.706f) / 0.001721f;
-  
-  if (_temp >= THERMAL_CRITICAL) {
-    _throttled = true;
-    if (_profile > PROFILE_POWERSAVE) _apply(PROFILE_POWERSAVE);
-  } else if (_temp >= THERMAL_THROTTLE && !_throttled) {
-    _throttled = true;
-    if (_profile > PROFILE_BALANCED) _apply(PROFILE_BALANCED);
-  } else if (_temp < THERMAL_RELEASE) {
-    _throttled = false;
-  }
+// Like _qosMove(): a pinned override stays pinned
+void PicomimiGovernorClass::_phaseMove(uint8_t level) {
+  if (_override_on || level >= _opp_count) return;
+  uint8_t target = _capLevel(level);
+  if (target != _level) _apply(target, TRACE_PHASE);
+}
+
+// Hardware spinlock once begin() has claimed one; before that there is
+// only one context to keep out
+uint32_t PicomimiGovernorClass::_lockQos() {
+  return _lock ? spin_lock_blocking(_lock) : save_and_disable_interrupts();
+}
+
+void PicomimiGovernorClass::_unlockQos(uint32_t irq) {
+  if (_lock) spin_unlock(_lock, irq);
+  else restore_interrupts(irq);
 }
 
 // ============================================================================
-// INTERNAL - Timeouts
+// CROSS-CORE CONTROL
 // ============================================================================
 
-void PicomimiGovernorClass::_timeouts() {
-  uint32_t now = to_ms_since_boot(get_absolute_time());
-  
-  if (_turbo_on && (now - _turbo_start_ms >= TURBO_MAX_MS)) {
-    _turbo_on = false;
-    if (_profile == PROFILE_TURBO) _apply(PROFILE_PERFORMANCE);
+// Thread code on the scaling core can act in place: the tick never
+// interrupts a level change (_busy), and nothing else changes levels
+bool PicomimiGovernorClass::_direct() {
+  return !_init || (get_core_num() == _owner_core && __get_current_exception() == 0);
+}
+
+// Single producer per ring: the caller's own core, with its interrupts
+// held off so an ISR can't interleave with thread code on that core
+void PicomimiGovernorClass::_post(uint8_t op, uint8_t level, uint32_t arg) {
+  Mailbox& m = _mbox[get_core_num()];
+  uint32_t irq = save_and_disable_interrupts();
+  uint8_t head = m.head;
+  if ((uint8_t)(head - m.tail) >= PICOMIMI_MAILBOX_SIZE) {
+    _mbox_dropped = _mbox_dropped + 1;
+  } else {
+    GovCommand& c = m.ring[head & (PICOMIMI_MAILBOX_SIZE - 1)];
+    c.op = op;
+    c.level = level;
+    c.arg = arg;
+    __dmb();
+    m.head = head + 1;
+    __dmb();
+    _mbox_pending = true;
+    __sev();                    // Wakes a governor core sitting in WFE
   }
-  
-  if (_boost_on && (now - _boost_start_ms >= BOOST_DURATION_MS)) _boost_on = false;
-  
-  if (_override_on && _override_end_ms > 0 && now >= _override_end_ms) {
-    _override_on = false;
-    _override_end_ms = 0;
-    if (_manual) Serial.println(F("[GOV] Override expired"));
+  restore_interrupts(irq);
+}
+
+// Only ever called from one context: run() in SERVICE_LOOP, the decide
+// interrupt in SERVICE_TIMER, core1's loop in SERVICE_CORE1
+void PicomimiGovernorClass::_drain() {
+  _mbox_pending = false;
+  __dmb();
+  for (uint8_t i = 0; i < PICOMIMI_NUM_CORES; i++) {
+    Mailbox& m = _mbox[i];
+    while (m.tail != m.head) {
+      __dmb();
+      GovCommand c = m.ring[m.tail & (PICOMIMI_MAILBOX_SIZE - 1)];
+      __dmb();
+      m.tail = m.tail + 1;
+      _execute(c);
+    }
   }
+  _publish();
 }
 
-// ============================================================================
-// INTERNAL - WFI & Voltage
-// ============================================================================
+void PicomimiGovernorClass::_execute(const GovCommand& cmd) {
+  switch (cmd.op) {
+    case MBOX_OPP:   if (cmd.level < _opp_count) _doOpp(cmd.level, cmd.arg); break;
+    case MBOX_AUTO:  _override_on = false; _override_end_ms = 0; break;
+    case MBOX_BOOST: _doBoost(); break;
+    case MBOX_QOS:   _qosMove(); break;
+    case MBOX_POLICY: {
+      if (cmd.level < POLICY_CUSTOM) { _selectPolicy(cmd.level, &BUILTIN_POLICIES[cmd.level]); break; }
+      uint32_t irq = spin_lock_blocking(_lock);
+      const PolicyOps* ops = _ops_stage;
+      spin_unlock(_lock, irq);
+      _selectPolicy(POLICY_CUSTOM, ops);
+      break;
+    }
+    case MBOX_TUNE: {
+      uint32_t irq = spin_lock_blocking(_lock);
+      GovernorTunables t = _tune_stage;
+      spin_unlock(_lock, irq);
+      _applyTunables(t);
+      break;
+    }
+    case MBOX_DEADLINE: _deadlineMove(); break;
+    case MBOX_PHASE: _phaseMove(cmd.level); break;
+  }
+}
+
+// Writes the slot readers aren't pointed at, then flips. Writers are all
+// on the scaling core; masking interrupts keeps them from nesting.
+void PicomimiGovernorClass::_publish() {
+  uint32_t irq = save_and_disable_interrupts();
+  uint32_t next = _snap_seq + 1;
+  GovernorStatus& s = _snap[next & 1];
+  s.freq_khz = _freq_khz;
+  s.cap_khz = _opp_count ? _table[_cap_level].khz : 0;
+  s.avg_load = _avg_load;
+  s.instant_load = _instant_load;
+  for (uint8_t i = 0; i < PICOMIMI_NUM_CORES; i++) s.core_load[i] = _cores[i].avg_load;
+  s.temp_mc = (int32_t)(_temp * 1000.0f);
+  s.level = _level;
+  s.profile = _opp_count ? (uint8_t)_profileOf(_level) : (uint8_t)PROFILE_BALANCED;
+  s.turbo = _turbo_on;
+  s.throttled = _throttled;
+  s.boost = _boost_on;
+  s.override_on = _override_on;
+  __dmb();
+  _snap_seq = next;
+  restore_interrupts(irq);
+}
 
-void PicomimiGovernorClass::_wfi() { __wfi(); }
+void PicomimiGovernorClass::setLoadMix(LoadMix mix, uint8_t core1_weight) {
+  _load_mix = mix;
+  _core1_weight = core1_weight > 100 ? 100 : core1_weight;
+}
 
-vreg_voltage PicomimiGovernorClass::_toVreg(uint32_t mv) {
-  if (mv <= 850) return VREG_VOLTAGE_0_85;
-  if (mv <= 900) return VREG_VOLTAGE_0_90;
-  if (mv <= 950) return VREG_VOLTAGE_0_95;
-  if (mv <= 1000) return VREG_VOLTAGE_1_00;
-  if (mv <= 1050) return VREG_VOLTAGE_1_05;
-  if (mv <= 1100) return VREG_VOLTAGE_1_10;
-  if (mv <= 1150) return VREG_VOLTAGE_1_15;
-  if (mv <= 1200) return VREG_VOLTAGE_1_20;
-  if (mv <= 1250) return VREG_VOLTAGE_1_25;
-  return VREG_VOLTAGE_1_30;
+void PicomimiGovernorClass::setPolicy(ScalingPolicy policy) {
+  if (policy >= POLICY_CUSTOM) return;
+  if (_direct()) _selectPolicy(policy, &BUILTIN_POLICIES[policy]);
+  else _post(MBOX_POLICY, policy, 0);
+}
+
+void PicomimiGovernorClass::setPolicy(const PolicyOps& ops) {
+  if (_direct()) { _selectPolicy(POLICY_CUSTOM, &ops); return; }
+  uint32_t irq = spin_lock_blocking(_lock);
+  _ops_stage = &ops;
+  spin_unlock(_lock, irq);
+  _post(MBOX_POLICY, POLICY_CUSTOM, 0);
+}
+
+// Scaling context only, so the swap lands between decisions; _busy
+// keeps this core's decide interrupt off the half-swapped state
+void PicomimiGovernorClass::_selectPolicy(uint8_t policy, const PolicyOps* ops) {
+  bool was_busy = _busy;
+  _busy = true;
+  _policy = (ScalingPolicy)policy;
+  _ops = ops;
+  memset(&_pstate, 0, sizeof(_pstate));
+  _base_level = _level;
+  _pred_raised = false;
+  _pred_dirty = true;
+  _busy = was_busy;
+}
+
+ScalingPolicy PicomimiGovernorClass::getPolicy() { return _policy; }
+const char* PicomimiGovernorClass::getPolicyName() { return _ops->name; }
+
+uint32_t PicomimiGovernorClass::getBurstPeriodUs(uint8_t core) {
+  return core < PICOMIMI_NUM_CORES ? _cores[core].pred_period_us : 0;
 }
 
 // ============================================================================
-// MANUAL MODE
+// OPERATING POINTS
 // ============================================================================
 
-void PicomimiGovernorClass::_handleSerial() {
-  while (Serial.available()) {
-    char c = Serial.read();
-    if (c == '\n' || c == '\r') {
-      _cmd.trim();
-      _cmd.toLowerCase();
-      if (_cmd.length() > 0) {
-        if (_cmd == "gov" || _cmd == "help" || _cmd == "?") _printHelp();
-        else if (_cmd == "status" || _cmd == "s") _printStatus();
-        else if (_cmd == "auto" || _cmd == "a") { setAuto(); Serial.println(F("[GOV] Auto")); }
-        else if (_cmd.startsWith("turbo")) {
-          uint32_t sec = 30;
-          int sp = _cmd.indexOf(' ');
-          if (sp > 0) sec = _cmd.substring(sp + 1).toInt();
-          setTurbo(sec > 3600 ? 3600 : sec);
-          Serial.print(F("[GOV] TURBO ")); Serial.print(sec); Serial.println(F("s"));
-        }
-        else if (_cmd.startsWith("save") || _cmd.startsWith("power")) {
-          uint32_t sec = 60;
-          int sp = _cmd.indexOf(' ');
-          if (sp > 0) sec = _cmd.substring(sp + 1).toInt();
-          setPowersave(sec);
-          Serial.print(F("[GOV] POWERSAVE ")); Serial.print(sec); Serial.println(F("s"));
-        }
-        else if (_cmd.startsWith("bal")) {
-          uint32_t sec = 0;
-          int sp = _cmd.indexOf(' ');
-          if (sp > 0) sec = _cmd.substring(sp + 1).toInt();
-          setProfile(PROFILE_BALANCED, sec);
-          Serial.println(F("[GOV] BALANCED"));
-        }
-        else if (_cmd.startsWith("perf")) {
-          uint32_t sec = 0;
-          int sp = _cmd.indexOf(' ');
-          if (sp > 0) sec = _cmd.substring(sp + 1).toInt();
-          setProfile(PROFILE_PERFORMANCE, sec);
-          Serial.println(F("[GOV] PERFORMANCE"));
-        }
-        else if (_cmd.startsWith("ultra") || _cmd.startsWith("low")) {
-          setProfile(PROFILE_ULTRA_LOW, 0);
-          Serial.println(F("[GOV] ULTRA_LOW"));
-        }
-        else Serial.println(F("[GOV] Unknown. Type 'gov'"));
-      }
-      _cmd = "";
-    } else _cmd += c;
+bool PicomimiGovernorClass::setOperatingPoints(const OperatingPoint* opps, uint8_t count) {
+  if (_init || opps == nullptr || count == 0 || count > PICOMIMI_MAX_OPPS) return false;
+  for (uint8_t i = 0; i < count; i++) {
+    _opps[i].pll.khz = opps[i].khz;
+    _opps[i].nominal_mv = (uint16_t)opps[i].mv;
   }
+  _custom_count = count;
+  return true;
 }
 
-void PicomimiGovernorClass::_printHelp() {
-  Serial.println(F("\n╔══════════════════════════════════════════╗"));
-  Serial.println(F("║  PICOMIMI CPU GOVERNOR                   ║"));
-  Serial.println(F("╚══════════════════════════════════════════╝\n"));
-  Serial.println(F("Commands:"));
-  Serial.println(F("  status      Show status"));
-  Serial.println(F("  auto        Auto scaling"));
-  Serial.println(F("  turbo [s]   Turbo for N sec"));
-  Serial.println(F("  save [s]    Powersave for N sec"));
-  Serial.println(F("  balanced    Balanced mode"));
-  Serial.println(F("  perf        Performance mode"));
-  Serial.println(F("  ultra       Ultra-low power\n"));
-  Serial.println(F("Tip: Use PicomimiGov.idle(ms) instead of delay()"));
+uint8_t PicomimiGovernorClass::getOppCount() { return _opp_count; }
+uint8_t PicomimiGovernorClass::getOpp() { return _level; }
+
+uint32_t PicomimiGovernorClass::getOppFreqMHz(uint8_t level) {
+  return level < _opp_count ? _opps[level].pll.khz / 1000 : 0;
+}
+
+// ============================================================================
+// UNDERVOLT CALIBRATION
+// ============================================================================
+
+// Stored curve. Keyed by frequency so it survives table edits that
+// keep some of the same points.
+struct CalRecord {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t chip;
+  uint8_t count;
+  uint8_t guard;
+  uint32_t khz[PICOMIMI_MAX_OPPS];
+  uint16_t mv[PICOMIMI_MAX_OPPS];
+  uint32_t crc;
+};
+
+#define CAL_MAGIC    0x56434750   // "PGCV"
+#define CAL_VERSION  1
+
+// zlib's CRC-32, a nibble at a time: 64 bytes of table, ~4x the bitwise
+// loop, cheap enough for a telemetry frame every decision
+static const uint32_t CRC32_NIBBLE[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t _crc32(const void* data, size_t len, uint32_t crc = 0) {
+  const uint8_t* p = (const uint8_t*)data;
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ CRC32_NIBBLE[crc & 15];
+    crc = (crc >> 4) ^ CRC32_NIBBLE[crc & 15];
+  }
+  return ~crc;
+}
+
+// Test kernel: fill, CRC and a small integer matrix multiply. Marginal
+// voltage shows up as a wrong answer long before it shows up as a hang.
+#define CAL_BUF_WORDS 256
+#define CAL_MAT_N     8
+static uint32_t _cal_buf[CAL_BUF_WORDS];
+
+static uint32_t _calKernel(uint32_t seed) {
+  uint32_t x = seed;
+  for (uint32_t i = 0; i < CAL_BUF_WORDS; i++) {
+    x = x * 1664525 + 1013904223;
+    _cal_buf[i] = x;
+  }
+  uint32_t crc = _crc32(_cal_buf, sizeof(_cal_buf));
+  
+  const uint32_t* a = _cal_buf;
+  const uint32_t* b = _cal_buf + CAL_MAT_N * CAL_MAT_N;
+  uint32_t acc = 0;
+  for (uint8_t r = 0; r < CAL_MAT_N; r++) {
+    for (uint8_t c = 0; c < CAL_MAT_N; c++) {
+      uint32_t sum = 0;
+      for (uint8_t k = 0; k < CAL_MAT_N; k++) sum += a[r * CAL_MAT_N + k] * b[k * CAL_MAT_N + c];
+      acc = (acc << 1 | acc >> 31) ^ sum;
+    }
+  }
+  return crc ^ acc;
+}
+
+static inline uint8_t _mvToStep(uint32_t mv) {
+  return mv <= CAL_MIN_MV ? 0 : (uint8_t)((mv - CAL_MIN_MV) / CAL_STEP_MV);
+}
+
+static inline uint16_t _stepToMv(uint8_t step) {
+  return (uint16_t)(CAL_MIN_MV + step * CAL_STEP_MV);
+}
+
+// Progress lives in watchdog scratch 0-3 (the SDK only uses 4-7), so a
+// hang mid-trial doesn't lose the levels already done: scratch[0] holds
+// magic/level/step of the running trial, scratch[1..3] a nibble per level.
+static void _calSaveProgress(uint8_t level, uint8_t step, const uint8_t* found) {
+  uint32_t packed[3] = { 0, 0, 0 };
+  for (uint8_t i = 0; i < PICOMIMI_MAX_OPPS; i++) packed[i / 8] |= (uint32_t)(found[i] & 0xF) << ((i % 8) * 4);
+  watchdog_hw->scratch[1] = packed[0];
+  watchdog_hw->scratch[2] = packed[1];
+  watchdog_hw->scratch[3] = packed[2];
+  watchdog_hw->scratch[0] = ((uint32_t)CAL_SCRATCH_MAGIC << 16) | ((uint32_t)level << 8) | step;
+}
+
+bool PicomimiGovernorClass::calibrate(uint8_t guard_steps) {
+  if (!_init) return false;
+  if (_service_mode == SERVICE_CORE1 && get_core_num() != _owner_core) return false;   // Serial 'cal' only
+  
+  uint8_t found[PICOMIMI_MAX_OPPS];
+  for (uint8_t i = 0; i < PICOMIMI_MAX_OPPS; i++) found[i] = i < _opp_count ? _mvToStep(_opps[i].nominal_mv) : 0;
+  
+  // Resume after the watchdog caught a hang: that step failed, the one
+  // above it was the last that passed
+  uint8_t start = 0;
+  uint32_t s0 = watchdog_hw->scratch[0];
+  if (watchdog_caused_reboot() && (s0 >> 16) == CAL_SCRATCH_MAGIC) {
+    uint8_t level = (s0 >> 8) & 0xFF;
+    for (uint8_t i = 0; i < level && i < PICOMIMI_MAX_OPPS; i++) {
+      found[i] = (watchdog_hw->scratch[1 + i / 8] >> ((i % 8) * 4)) & 0xF;
+    }
+    if (level < _opp_count) {
+      found[level] = (s0 & 0xFF) + 1;
+      start = level + 1;
+    }
+    if (_manual) { Serial.print(F("[GOV] Calibration resumed after hang at OPP ")); Serial.println(level); }
+  }
+  
+  uint8_t prev_level = _level;
+  _busy = true;
+  
+  for (uint8_t l = start; l < _opp_count; l++) {
+    uint8_t nominal = _mvToStep(_opps[l].nominal_mv);
+    _table[l].mv = _opps[l].nominal_mv;
+    _apply(l, TRACE_OVERRIDE);
+    vreg_set_voltage(_toVreg(_opps[l].nominal_mv));
+    _waitVreg();
+    
+    uint32_t ref = _calKernel(l + 1);
+    uint8_t best = nominal;
+    
+    for (int8_t step = nominal - 1; step >= 0; step--) {
+      _calSaveProgress(l, step, found);
+      watchdog_enable(CAL_WATCHDOG_MS, true);
+      
+      vreg_set_voltage(_toVreg(_stepToMv(step)));
+      busy_wait_us_32(VREG_SETTLE_MAX_US);
+      bool ok = _calTrial(ref, CAL_TRIAL_MS);
+      vreg_set_voltage(_toVreg(_opps[l].nominal_mv));
+      _waitVreg();
+      
+      hw_clear_bits(&watchdog_hw->ctrl, WATCHDOG_CTRL_ENABLE_BITS);
+      if (!ok) break;
+      best = step;
+    }
+    found[l] = best;
+    
+    if (_manual) {
+      Serial.print(F("[GOV] OPP ")); Serial.print(l); Serial.print(F(" @ "));
+      Serial.print(_opps[l].pll.khz / 1000); Serial.print(F(" MHz stable at "));
+      Serial.print(_stepToMv(best)); Serial.println(F(" mV"));
+    }
+  }
+  watchdog_hw->scratch[0] = 0;
+  
+  CalRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.magic = CAL_MAGIC;
+  rec.version = CAL_VERSION;
+  rec.chip = _chip;
+  rec.count = _opp_count;
+  rec.guard = guard_steps;
+  for (uint8_t i = 0; i < _opp_count; i++) {
+    uint16_t mv = _stepToMv(found[i] + guard_steps);
+    if (mv > _opps[i].nominal_mv) mv = _opps[i].nominal_mv;
+    rec.khz[i] = _opps[i].pll.khz;
+    rec.mv[i] = mv;
+    _table[i].mv = mv;
+  }
+  rec.crc = _crc32(&rec, offsetof(CalRecord, crc));
+  bool saved = _flashSave(FLASH_SLOT_CAL, &rec, sizeof(rec));
+  _calibrated = true;
+  
+  _apply(prev_level, TRACE_OVERRIDE);
+  vreg_set_voltage(_toVreg(_table[_level].mv));
+  _busy = false;
+  return saved;
+}
+
+bool PicomimiGovernorClass::hasCalibration() { return _calibrated; }
+
+void PicomimiGovernorClass::clearCalibration() {
+  CalRecord rec;
+  memset(&rec, 0xFF, sizeof(rec));
+  _flashSave(FLASH_SLOT_CAL, &rec, sizeof(rec));
+  for (uint8_t i = 0; i < _opp_count; i++) _table[i].mv = _opps[i].nominal_mv;
+  _calibrated = false;
+  if (_init) vreg_set_voltage(_toVreg(_table[_level].mv));
+}
+
+uint32_t PicomimiGovernorClass::getOppVoltage(uint8_t level) {
+  return level < _opp_count ? _table[level].mv : 0;
+}
+
+// Keeps kicking the watchdog, so only a hang (not a slow kernel) trips it
+bool PicomimiGovernorClass::_calTrial(uint32_t ref, uint32_t ms) {
+  uint32_t t0 = time_us_32();
+  uint32_t seed = _level + 1;
+  while (time_us_32() - t0 < ms * 1000) {
+    if (_calKernel(seed) != ref) return false;
+    watchdog_update();
+  }
+  return true;
+}
+
+bool PicomimiGovernorClass::_loadCalibration() {
+  _calibrated = false;
+  CalRecord rec;
+  if (!_flashLoad(FLASH_SLOT_CAL, &rec, sizeof(rec))) return false;
+  if (rec.magic != CAL_MAGIC || rec.version != CAL_VERSION || rec.chip != _chip) return false;
+  if (rec.count > PICOMIMI_MAX_OPPS || rec.crc != _crc32(&rec, offsetof(CalRecord, crc))) return false;
+  
+  for (uint8_t i = 0; i < _opp_count; i++) {
+    for (uint8_t j = 0; j < rec.count; j++) {
+      if (rec.khz[j] == _opps[i].pll.khz && rec.mv[j] < _opps[i].nominal_mv) {
+        _table[i].mv = rec.mv[j];
+        _calibrated = true;
+      }
+    }
+  }
+  return _calibrated;
+}
+
+// ============================================================================
+// INTERNAL - Flash Storage
+// ============================================================================
+
+bool PicomimiGovernorClass::_flashLoad(uint8_t slot, void* data, size_t len) {
+  if (len > FLASH_PAGE_SIZE) return false;
+  uint32_t offset = PICOMIMI_FLASH_OFFSET - slot * FLASH_SECTOR_SIZE;
+  memcpy(data, (const void*)(uintptr_t)(XIP_BASE + offset), len);
+  return true;
+}
+
+// Records are at most a page. The other core is parked and interrupts
+// are off while the sector is erased and programmed, same as EEPROM.commit().
+bool PicomimiGovernorClass::_flashSave(uint8_t slot, const void* data, size_t len) {
+  if (len > FLASH_PAGE_SIZE) return false;
+  uint32_t offset = PICOMIMI_FLASH_OFFSET - slot * FLASH_SECTOR_SIZE;
+  
+  extern uint8_t __flash_binary_end;
+  if (XIP_BASE + offset < (uintptr_t)&__flash_binary_end) return false;
+  
+  uint8_t page[FLASH_PAGE_SIZE];
+  memset(page, 0xFF, sizeof(page));
+  memcpy(page, data, len);
+  
+  beginFlashWrite();
+  rp2040.idleOtherCore();
+  noInterrupts();
+  flash_range_erase(offset, FLASH_SECTOR_SIZE);
+  flash_range_program(offset, page, FLASH_PAGE_SIZE);
+  interrupts();
+  rp2040.resumeOtherCore();
+  endFlashWrite();
+  return true;
+}
+
+// Our own core1 doesn't answer the core's idleOtherCore(), so in
+// SERVICE_CORE1 it would keep running from XIP through an erase. Both
+// cores are lockout victims there instead. Nests.
+void PicomimiGovernorClass::beginFlashWrite() {
+  if (!_init || _service_mode != SERVICE_CORE1) return;
+  if (_flash_depth++ == 0) multicore_lockout_start_blocking();
+}
+
+void PicomimiGovernorClass::endFlashWrite() {
+  if (!_init || _service_mode != SERVICE_CORE1 || _flash_depth == 0) return;
+  if (--_flash_depth == 0) multicore_lockout_end_blocking();
+}
+
+// ============================================================================
+// TRACE
+// ============================================================================
+
+#define TRACE_VERSION 1
+
+static_assert((PICOMIMI_TRACE_SIZE & (PICOMIMI_TRACE_SIZE - 1)) == 0, "PICOMIMI_TRACE_SIZE must be a power of two");
+static_assert(sizeof(TraceRecord) == 16, "TraceRecord must stay 16 bytes, the host decoder depends on it");
+
+uint16_t PicomimiGovernorClass::getTraceCount() { return _trace_count; }
+
+bool PicomimiGovernorClass::getTrace(uint16_t i, TraceRecord& out) {
+  uint32_t irq = save_and_disable_interrupts();
+  bool ok = i < _trace_count;
+  if (ok) out = _trace_buf[(_trace_head - _trace_count + i) & (PICOMIMI_TRACE_SIZE - 1)];
+  restore_interrupts(irq);
+  return ok;
+}
+
+void PicomimiGovernorClass::clearTrace() {
+  uint32_t irq = save_and_disable_interrupts();
+  _trace_head = 0;
+  _trace_count = 0;
+  restore_interrupts(irq);
+}
+
+// Positions are snapshotted once, so records that land mid-dump don't
+// shift the rest. A writer that laps a slot not sent yet bumps _trace_seq
+// past it first; that record goes out zeroed rather than torn.
+void PicomimiGovernorClass::dumpTrace(Print& out) {
+  uint32_t irq = save_and_disable_interrupts();
+  uint32_t seq = _trace_seq;
+  uint16_t head = _trace_head;
+  uint16_t count = _trace_count;
+  restore_interrupts(irq);
+  uint8_t hdr[8] = { 'P', 'G', 'T', 'R', TRACE_VERSION, (uint8_t)sizeof(TraceRecord),
+                     (uint8_t)(count & 0xFF), (uint8_t)(count >> 8) };
+  uint32_t crc = _crc32(hdr, sizeof(hdr));
+  out.write(hdr, sizeof(hdr));
+  
+  TraceRecord r;
+  for (uint16_t i = 0; i < count; i++) {
+    irq = save_and_disable_interrupts();
+    r = _trace_buf[(head - count + i) & (PICOMIMI_TRACE_SIZE - 1)];
+    restore_interrupts(irq);
+    __dmb();
+    if (_trace_seq - seq > (uint32_t)(PICOMIMI_TRACE_SIZE - count + i)) memset(&r, 0, sizeof(r));
+    crc = _crc32(&r, sizeof(r), crc);
+    out.write((const uint8_t*)&r, sizeof(r));
+  }
+  out.write((const uint8_t*)&crc, sizeof(crc));
+}
+
+// ============================================================================
+// TELEMETRY
+// ============================================================================
+
+#define TELEMETRY_VERSION 1
+
+static_assert(sizeof(TelemetryRecord) == 28, "TelemetryRecord must stay 28 bytes, the host decoder depends on it");
+
+// Stopped while the sink changes, so the decide interrupt never sees
+// half of it
+void PicomimiGovernorClass::setTelemetry(Print& out, uint32_t period_ms) {
+  _tm_period_ms = 0;
+  _tm_cb = nullptr;
+  _tm_out = &out;
+  _tm_next_ms = 0;
+  _tm_period_ms = period_ms;
+}
+
+void PicomimiGovernorClass::setTelemetry(TelemetryCallback cb, void* ctx, uint32_t period_ms) {
+  _tm_period_ms = 0;
+  _tm_out = nullptr;
+  _tm_cb = cb;
+  _tm_ctx = ctx;
+  _tm_next_ms = 0;
+  _tm_period_ms = cb ? period_ms : 0;
+}
+
+void PicomimiGovernorClass::stopTelemetry() { _tm_period_ms = 0; }
+
+// After the decision: a Print sink from _service() in thread context, a
+// callback wherever decisions run. The first frame's residency covers
+// everything since begin() (or resetStats()).
+void PicomimiGovernorClass::_telemetry() {
+  uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+  if (_tm_next_ms && (int32_t)(now_ms - _tm_next_ms) < 0) return;
+  _tm_next_ms = now_ms + _tm_period_ms;
+  
+  uint8_t n = _opp_count;
+  uint8_t* p = _tm_buf;
+  p[0] = 'P'; p[1] = 'G'; p[2] = 'T'; p[3] = 'M';
+  p[4] = TELEMETRY_VERSION;
+  p[5] = (uint8_t)sizeof(TelemetryRecord);
+  p[6] = n;
+  p[7] = 0;
+  
+  TelemetryRecord r;
+  r.time_ms = now_ms;
+  r.transitions = _transitions;
+  r.seq = _tm_seq++;
+  r.mhz = (uint16_t)(_freq_khz / 1000);
+  r.cap_mhz = n ? (uint16_t)(_table[_cap_level].khz / 1000) : 0;
+  r.temp_dc = (int16_t)(_temp * 10.0f);
+  r.throttles = (uint16_t)_throttle_count;
+  r.stall_max_us = _stall_max_us > 0xFFFF ? 0xFFFF : (uint16_t)_stall_max_us;
+  r.deadline_misses = (uint16_t)_deadline_misses;
+  for (uint8_t i = 0; i < 2; i++) {
+    r.core_load[i] = i < PICOMIMI_NUM_CORES ? (uint8_t)(_cores[i].avg_load >> 16) : 0;
+  }
+  r.avg_load = (uint8_t)(_avg_load >> 16);
+  r.level = _level;
+  r.flags = (_throttled ? 1 : 0) | (_override_on ? 2 : 0) | (_boost_on ? 4 : 0) | (_turbo_on ? 8 : 0);
+  r.reserved = 0;
+  memcpy(p + 8, &r, sizeof(r));
+  p += 8 + sizeof(r);
+  
+  // Residency: the low word of each total is enough for a delta
+  uint32_t delta[PICOMIMI_MAX_OPPS];
+  uint32_t total = 0;
+  uint32_t irq = save_and_disable_interrupts();
+  _accountState(time_us_64());
+  for (uint8_t i = 0; i < n; i++) {
+    uint32_t t = (uint32_t)_stats[i].time_us;
+    delta[i] = t - _tm_res_us[i];
+    _tm_res_us[i] = t;
+    total += delta[i];
+  }
+  restore_interrupts(irq);
+  for (uint8_t i = 0; i < n; i++) {
+    uint16_t pm = total ? (uint16_t)((uint64_t)delta[i] * 1000 / total) : 0;
+    *p++ = (uint8_t)(pm & 0xFF);
+    *p++ = (uint8_t)(pm >> 8);
+  }
+  
+  uint32_t crc = _crc32(_tm_buf, p - _tm_buf);
+  memcpy(p, &crc, sizeof(crc));
+  size_t len = p + sizeof(crc) - _tm_buf;
+  
+  if (_tm_cb) _tm_cb(_tm_buf, len, _tm_ctx);
+  else if (_tm_out) _tm_out->write(_tm_buf, len);
+}
+
+// Called with _busy set (from _apply) or from the scaling context
+void PicomimiGovernorClass::_trace(uint8_t from, uint8_t to, TraceReason why) {
+  _trace_seq++;
+  __dmb();
+  TraceRecord& r = _trace_buf[_trace_head];
+  r.time_ms = to_ms_since_boot(get_absolute_time());
+  r.temp_dc = (int16_t)(_temp * 10.0f);
+  r.stall_us = _stall_last_us > 0xFFFF ? 0xFFFF : (uint16_t)_stall_last_us;
+  r.mhz = (uint16_t)(_freq_khz / 1000);
+  r.instant_load = (uint8_t)(_instant_load >> 16);
+  r.avg_load = (uint8_t)(_avg_load >> 16);
+  r.from_level = from;
+  r.to_level = to;
+  r.reason = why;
+  r.flags = (_throttled ? 1 : 0) | (_override_on ? 2 : 0) | (_boost_on ? 4 : 0);
+  __dmb();
+  
+  _trace_head = (_trace_head + 1) & (PICOMIMI_TRACE_SIZE - 1);
+  if (_trace_count < PICOMIMI_TRACE_SIZE) _trace_count++;
+}
+
+// ============================================================================
+// DEADLINE
+// ============================================================================
+
+void PicomimiGovernorClass::setDeadline(uint32_t us, uint8_t margin_pct) {
+  _deadline_us = us;
+  _deadline_margin = margin_pct > 90 ? 90 : margin_pct;
+  _task_count = 0;
+  _task_head = 0;
+  _deadline_misses = 0;
+  memset(_task_cycles, 0, sizeof(_task_cycles));
+}
+
+void PicomimiGovernorClass::beginTask() {
+  _task_manual = true;
+  _task_start_us = time_us_64();
+}
+
+void PicomimiGovernorClass::endTask() {
+  if (!_task_manual) return;
+  _recordTask((uint32_t)(time_us_64() - _task_start_us));
+}
+
+uint32_t PicomimiGovernorClass::getTaskTimeUs() { return _task_us; }
+uint32_t PicomimiGovernorClass::getDeadlineMisses() { return _deadline_misses; }
+
+// ============================================================================
+// IDLE BACKEND
+// ============================================================================
+
+void PicomimiGovernorClass::setIdleMode(IdleMode mode, uint32_t min_sleep_us, uint32_t downclock_ms) {
+  _idle_mode = mode;
+  _min_sleep_us = min_sleep_us;
+  _downclock_ms = downclock_ms;
+}
+
+uint32_t PicomimiGovernorClass::getWakeLatencyUs() { return _wake_lat_us; }
+uint32_t PicomimiGovernorClass::getMaxWakeLatencyUs() { return _wake_lat_max_us; }
+uint32_t PicomimiGovernorClass::getDeepEntryUs() { return _deep_entry_us; }
+uint32_t PicomimiGovernorClass::getDeepExitUs() { return _deep_exit_us; }
+uint32_t PicomimiGovernorClass::getDeepIdleCount() { return _deep_count; }
+
+// Against IDLE_SLEEP at the current level: switching costs roughly a
+// busy core for entry + exit, then the crystal clock draws less
+uint32_t PicomimiGovernorClass::getDeepBreakEvenUs() {
+  if (_opp_count == 0) return 0xFFFFFFFF;
+  bool rp2350 = _chip == PICOMIMI_RP2350;
+  PolicyOpp deep = { XOSC_KHZ, _table[0].mv, 0, 0 };
+  uint32_t us = policyBreakEvenUs(_deep_entry_us + _deep_exit_us,
+                                  policyCurrentUa(_table[_level], 100, rp2350),
+                                  policyCurrentUa(_table[_level], 0, rp2350),
+                                  policyCurrentUa(deep, 0, rp2350));
+  return us > DEEP_MIN_US ? us : DEEP_MIN_US;
+}
+
+bool PicomimiGovernorClass::sleepUntilPin(uint8_t gpio, bool rising) {
+  if (!_deepOk()) return false;
+  bool busy = _busy;
+  _busy = true;
+  _deepEnter();
+  
+  // Interrupts stay off until pll_usb is back: USB and anything else on
+  // it would fault touching a block with no clock
+  uint32_t event = rising ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+  uint32_t irq = save_and_disable_interrupts();
+  gpio_set_dormant_irq_enabled(gpio, event, true);
+  pll_deinit(pll_usb);
+  xosc_dormant();                // Returns once the crystal is stable again
+  gpio_acknowledge_irq(gpio, event);
+  gpio_set_dormant_irq_enabled(gpio, event, false);
+  pll_init(pll_usb, PLL_COMMON_REFDIV, PLL_USB_VCO_FREQ_HZ, PLL_USB_POSTDIV1, PLL_USB_POSTDIV2);
+  restore_interrupts(irq);
+  
+  _deepExit();
+  _deep_count++;
+  _busy = busy;
+  return true;
+}
+
+// ============================================================================
+// TRANSITIONS
+// ============================================================================
+
+uint32_t PicomimiGovernorClass::getTransitionStallUs() { return _stall_last_us; }
+uint32_t PicomimiGovernorClass::getMaxTransitionStallUs() { return _stall_max_us; }
+uint32_t PicomimiGovernorClass::getTransitionCount() { return _transitions; }
+
+// ============================================================================
+// THERMAL
+// ============================================================================
+
+void PicomimiGovernorClass::setThermalTarget(float target_c) { _pid.target_c = target_c; }
+float PicomimiGovernorClass::getThermalTarget() { return _pid.target_c; }
+
+void PicomimiGovernorClass::setThermalGains(float kp, float ki, float kd) {
+  _pid.kp = kp;
+  _pid.ki = ki;
+  _pid.kd = kd;
+}
+
+bool PicomimiGovernorClass::setTempSampling(TempSampling mode, uint8_t app_inputs, uint32_t rate_hz) {
+  // Park the sampler first: it may be mid-read in the decide interrupt
+  // or on the other core, and must not restart the DMA torn down here
+  _temp_reconfig = true;
+  __dmb();
+  while (_temp_reading) tight_loop_contents();
+  if (!_adc_init) {
+    adc_init();
+    adc_set_temp_sensor_enabled(true);
+    _adc_init = true;
+  }
+  
+  _adcStop();
+  _temp_mode = TEMP_SAMPLE_SINGLE;
+  bool ok = true;
+  if (mode == TEMP_SAMPLE_DMA) {
+    _adc_inputs = app_inputs & 0x0F;
+    _adc_rate_hz = rate_hz ? rate_hz : 1;
+    ok = _adcStart();
+    if (ok) _temp_mode = TEMP_SAMPLE_DMA;
+  }
+  __dmb();
+  _temp_reconfig = false;
+  return ok;
+}
+
+TempSampling PicomimiGovernorClass::getTempSampling() { return _temp_mode; }
+
+uint16_t PicomimiGovernorClass::getAdcSample(uint8_t input) {
+  uint16_t v = 0;
+  if (_temp_mode == TEMP_SAMPLE_DMA) _adcRecent(input, &v, 1);
+  return v;
+}
+
+// ============================================================================
+// TUNABLES
+// ============================================================================
+
+struct TuneRecord {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t size;
+  uint16_t reserved;
+  GovernorTunables t;
+  uint32_t crc;
+};
+
+#define TUNE_MAGIC    0x4E544750   // "PGTN"
+#define TUNE_VERSION  2
+
+// Names as GovernorConfig spells them; drives set/get
+struct TunableField {
+  const char* name;
+  uint8_t offset;
+  uint8_t size;
+};
+
+#define TUNABLE(f) { #f, offsetof(GovernorTunables, f), sizeof(GovernorTunables::f) }
+static const TunableField TUNABLE_FIELDS[] = {
+  TUNABLE(turbo_up), TUNABLE(turbo_down), TUNABLE(perf_up), TUNABLE(perf_down),
+  TUNABLE(bal_up), TUNABLE(bal_down), TUNABLE(save_down), TUNABLE(ultra_down),
+  TUNABLE(load_smooth_pct), TUNABLE(sched_headroom_pct), TUNABLE(hispeed_load),
+  TUNABLE(target_load), TUNABLE(hispeed_hold_ms), TUNABLE(load_period_ms),
+  TUNABLE(scale_interval_ms), TUNABLE(turbo_max_ms), TUNABLE(boost_ms)
+};
+#undef TUNABLE
+
+// The runtime half of governorTunables()' static_asserts
+static bool _tunablesOk(const GovernorTunables& t) {
+  return t.save_down < t.bal_down && t.bal_down < t.perf_down && t.perf_down < t.turbo_down &&
+         t.bal_up < t.perf_up && t.perf_up < t.turbo_up && t.turbo_up <= 100 &&
+         t.bal_down < t.bal_up && t.perf_down < t.perf_up && t.turbo_down < t.turbo_up &&
+         t.ultra_down <= t.save_down &&
+         t.load_smooth_pct >= 1 && t.load_smooth_pct <= 100 && t.sched_headroom_pct >= 100 &&
+         t.hispeed_load <= 100 && t.target_load >= 1 && t.target_load <= 100 &&
+         t.scale_interval_ms > 0 && t.load_period_ms >= t.scale_interval_ms;
+}
+
+// Off the scaling context the set goes through the mailbox: the copy
+// waits in _tune_stage, and a later set before the drain replaces it
+bool PicomimiGovernorClass::setTunables(const GovernorTunables& t) {
+  if (!_tunablesOk(t)) return false;
+  if (_direct()) {
+    _applyTunables(t);
+    return true;
+  }
+  uint32_t irq = spin_lock_blocking(_lock);
+  _tune_stage = t;
+  spin_unlock(_lock, irq);
+  _post(MBOX_TUNE, 0, 0);
+  return true;
+}
+
+// Scaling context only. _busy keeps the decide interrupt off the table
+// on this core; the tick's load sample reads _cfg, so the copy itself
+// is done with interrupts off.
+void PicomimiGovernorClass::_applyTunables(const GovernorTunables& t) {
+  bool was_busy = _busy;
+  _busy = true;
+  bool retime = _init && t.scale_interval_ms != _cfg.scale_interval_ms;
+  uint32_t irq = save_and_disable_interrupts();
+  _cfg = t;
+  restore_interrupts(irq);
+  const uint32_t* freq = _chip == PICOMIMI_RP2350 ? PICOMIMI_RP2350_FREQ : PICOMIMI_RP2040_FREQ;
+  policyThresholds(_table, _opp_count, freq, _policyTuning());
+  // Owner context, so in SERVICE_CORE1 this is core1 and its own pool
+  if (retime) {
+    cancel_repeating_timer(&_tick_timer);
+    _armTick();
+  }
+  _busy = was_busy;
+}
+
+GovernorTunables PicomimiGovernorClass::getTunables() { return _cfg; }
+
+bool PicomimiGovernorClass::saveTunables() {
+  TuneRecord rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.magic = TUNE_MAGIC;
+  rec.version = TUNE_VERSION;
+  rec.size = sizeof(GovernorTunables);
+  rec.t = _cfg;
+  rec.crc = _crc32(&rec, offsetof(TuneRecord, crc));
+  return _flashSave(FLASH_SLOT_TUNE, &rec, sizeof(rec));
+}
+
+void PicomimiGovernorClass::clearTunables() {
+  TuneRecord rec;
+  memset(&rec, 0xFF, sizeof(rec));
+  _flashSave(FLASH_SLOT_TUNE, &rec, sizeof(rec));
+}
+
+// Stored set replaces the compiled-in one only if it still validates
+bool PicomimiGovernorClass::_loadTunables() {
+  TuneRecord rec;
+  if (!_flashLoad(FLASH_SLOT_TUNE, &rec, sizeof(rec))) return false;
+  if (rec.magic != TUNE_MAGIC || rec.version != TUNE_VERSION || rec.size != sizeof(GovernorTunables)) return false;
+  if (rec.crc != _crc32(&rec, offsetof(TuneRecord, crc)) || !_tunablesOk(rec.t)) return false;
+  _cfg = rec.t;
+  return true;
+}
+
+PolicyTuning PicomimiGovernorClass::_policyTuning() {
+  return PolicyTuning{
+    { 0, _cfg.bal_up, _cfg.bal_up, _cfg.perf_up, _cfg.turbo_up },
+    { 0, _cfg.save_down, _cfg.bal_down, _cfg.perf_down, _cfg.turbo_down },
+    _cfg.load_smooth_pct, _cfg.sched_headroom_pct,
+    _cfg.hispeed_load, _cfg.target_load, _cfg.hispeed_hold_ms
+  };
+}
+
+bool PicomimiGovernorClass::_setTunable(const char* name, uint32_t value) {
+  for (const TunableField& f : TUNABLE_FIELDS) {
+    if (strcmp(f.name, name) != 0) continue;
+    if (f.size == 1 && value > 0xFF) return false;
+    GovernorTunables t = _cfg;
+    uint8_t* p = (uint8_t*)&t + f.offset;
+    if (f.size == 1) *p = (uint8_t)value;
+    else memcpy(p, &value, sizeof(value));
+    return setTunables(t);
+  }
+  return false;
+}
+
+void PicomimiGovernorClass::_printTunables() {
+  Serial.println(F("\n─── Tunables ───"));
+  for (const TunableField& f : TUNABLE_FIELDS) {
+    const uint8_t* p = (const uint8_t*)&_cfg + f.offset;
+    uint32_t v = 0;
+    if (f.size == 1) v = *p;
+    else memcpy(&v, p, sizeof(v));
+    Serial.print(F("  ")); Serial.print(f.name);
+    for (uint8_t i = strlen(f.name); i < 20; i++) Serial.print(' ');
+    Serial.println(v);
+  }
+  Serial.println();
+}
+
+// ============================================================================
+// RESIDENCY & ENERGY
+// ============================================================================
+
+bool PicomimiGovernorClass::getResidency(uint8_t level, OppResidency& out) {
+  if (level >= _opp_count) return false;
+  uint32_t irq = save_and_disable_interrupts();
+  if (_init) _accountState(time_us_64());
+  const OppStats& st = _stats[level];
+  out.khz = _opps[level].pll.khz;
+  out.time_us = st.time_us;
+  out.entries = st.entries;
+  out.current_ua = _currentUa(level);
+  out.energy_uj = st.energy_nj / 1000;
+  restore_interrupts(irq);
+  return true;
+}
+
+uint64_t PicomimiGovernorClass::getEnergyUj() {
+  uint32_t irq = save_and_disable_interrupts();
+  if (_init) _accountState(time_us_64());
+  uint64_t nj = 0;
+  for (uint8_t i = 0; i < _opp_count; i++) nj += _stats[i].energy_nj;
+  restore_interrupts(irq);
+  return nj / 1000;
+}
+
+// Pin a point first (setOpp/setProfile) so the reading belongs to it
+void PicomimiGovernorClass::setMeasuredCurrent(float ma) {
+  if (!_init || ma <= 0) return;
+  uint32_t ua = (uint32_t)(ma * 1000.0f);
+  uint32_t irq = save_and_disable_interrupts();
+  _accountState(time_us_64());
+  _stats[_level].measured_ua = ua;
+  _current_scale = (float)ua / (float)_modelCurrentUa(_level);
+  restore_interrupts(irq);
+}
+
+void PicomimiGovernorClass::resetStats() {
+  uint32_t irq = save_and_disable_interrupts();
+  for (uint8_t i = 0; i < PICOMIMI_MAX_OPPS; i++) {
+    _stats[i].time_us = 0;
+    _stats[i].energy_nj = 0;
+    _stats[i].entries = 0;
+  }
+  memset(_tm_res_us, 0, sizeof(_tm_res_us));
+  _state_since_us = time_us_64();
+  restore_interrupts(irq);
+}
+
+// Books the time since the last call to the current level
+void PicomimiGovernorClass::_accountState(uint64_t now_us) {
+  uint64_t dt = now_us - _state_since_us;
+  OppStats& st = _stats[_level];
+  st.time_us += dt;
+  // uA x mV x us = 1e-15 J
+  st.energy_nj += (uint64_t)_currentUa(_level) * PICOMIMI_SUPPLY_MV * dt / 1000000ULL;
+  _state_since_us = now_us;
+}
+
+// Busy core: residency doesn't know how much of a stint was spent asleep
+uint32_t PicomimiGovernorClass::_modelCurrentUa(uint8_t level) {
+  return policyCurrentUa(_table[level], 100, _chip == PICOMIMI_RP2350);
+}
+
+uint32_t PicomimiGovernorClass::_currentUa(uint8_t level) {
+  if (_stats[level].measured_ua) return _stats[level].measured_ua;
+  return (uint32_t)(_modelCurrentUa(level) * _current_scale);
+}
+
+// ============================================================================
+// PERIPHERAL CLOCKS
+// ============================================================================
+
+void PicomimiGovernorClass::setFlashClock(uint32_t max_mhz) {
+  _flash_max_khz = max_mhz * 1000;
+  if (_init) {
+    _xipCapUpdate();
+    if (_direct()) _retuneFlash();
+  }
+}
+
+uint32_t PicomimiGovernorClass::getFlashClockMHz() { return _freq_khz / _flash_div / 1000; }
+void PicomimiGovernorClass::setXipLimit(uint8_t hit_pct) { _xip_limit = hit_pct > 100 ? 100 : hit_pct; }
+float PicomimiGovernorClass::getXipHitRate() { return _xip_acc ? _xip_hit * 100.0f / _xip_acc : 100.0f; }
+bool PicomimiGovernorClass::isXipBound() { return _xip_bound; }
+
+void PicomimiGovernorClass::setBusClassifier(uint8_t min_eff_pct) {
+  _bus_min_eff = min_eff_pct > 100 ? 100 : min_eff_pct;
+  _bus_eff = 100;
+  if (!_bus_min_eff) return;
+  busctrl_hw->counter[0].sel = arbiter_xip_main_perf_event_access;
+  busctrl_hw->counter[1].sel = arbiter_xip_main_perf_event_access_contested;
+  busctrl_hw->counter[2].sel = arbiter_sram0_perf_event_access;
+  busctrl_hw->counter[3].sel = arbiter_sram0_perf_event_access_contested;
+  for (uint8_t i = 0; i < 4; i++) busctrl_hw->counter[i].value = 0;
+}
+
+uint8_t PicomimiGovernorClass::getBusEfficiency() { return _bus_eff; }
+
+void PicomimiGovernorClass::setPeriClock(PeriClock mode) {
+  _peri_clock = mode;
+  _applyPeriClock();
+}
+
+bool PicomimiGovernorClass::addClockHook(ClockChangeHook hook, void* ctx) {
+  if (!hook) return false;
+  for (uint8_t i = 0; i < PICOMIMI_MAX_CLOCK_HOOKS; i++) {
+    if (_hooks[i] == nullptr || _hooks[i] == hook) {
+      _hook_ctx[i] = ctx;
+      _hooks[i] = hook;
+      return true;
+    }
+  }
+  return false;
+}
+
+void PicomimiGovernorClass::removeClockHook(ClockChangeHook hook) {
+  for (uint8_t i = 0; i < PICOMIMI_MAX_CLOCK_HOOKS; i++) {
+    if (_hooks[i] == hook) _hooks[i] = nullptr;
+  }
+}
+
+// ============================================================================
+// INTERNAL - Setup
+// ============================================================================
+
+void PicomimiGovernorClass::_setupTables() {
+  bool rp2350 = _chip == PICOMIMI_RP2350;
+  const uint32_t* freq = rp2350 ? PICOMIMI_RP2350_FREQ : PICOMIMI_RP2040_FREQ;
+  const PllConfig* pll = rp2350 ? RP2350_PLL : RP2040_PLL;
+  
+  // Custom points: keep the ones the PLL can make, in rising order.
+  // Same search as the built-in tables, just at runtime.
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < _custom_count; i++) {
+    PllConfig c = _pllFor(_opps[i].pll.khz);
+    if (c.vco_khz == 0) continue;
+    if (n > 0 && c.khz <= _opps[n - 1].pll.khz) continue;
+    uint16_t mv = _opps[i].nominal_mv;
+    _opps[n].pll = c;
+    _opps[n].nominal_mv = mv;
+    _table[n].khz = c.khz;
+    _table[n].mv = mv;
+    n++;
+  }
+  _custom_count = n;
+  
+  if (n == 0) {
+    n = policyBuiltin(_table, rp2350, _policyTuning());
+    for (uint8_t i = 0; i < n; i++) {
+      _opps[i].pll = pll[i];
+      _opps[i].nominal_mv = _table[i].mv;
+    }
+  }
+  _opp_count = n;
+  
+  // Profiles alias the point nearest their built-in frequency
+  for (uint8_t p = 0; p < PROFILE_COUNT; p++) _alias[p] = _nearestLevel(freq[p]);
+  
+  policyThresholds(_table, n, freq, _policyTuning());
+}
+
+uint8_t PicomimiGovernorClass::_nearestLevel(uint32_t khz) {
+  return policyNearest(_table, _opp_count, khz);
+}
+
+uint8_t PicomimiGovernorClass::_levelAtLeast(uint32_t khz) {
+  return policyAtLeast(_table, _opp_count, khz);
+}
+
+// Profile names for a level: the highest profile aliased at or below it
+uint8_t PicomimiGovernorClass::_profileOf(uint8_t level) {
+  uint8_t p = PROFILE_ULTRA_LOW;
+  while (p + 1 < PROFILE_COUNT && _alias[p + 1] <= level) p++;
+  return p;
+}
+
+// ============================================================================
+// INTERNAL - Idle Sampler
+// ============================================================================
+
+// Each sampled core gets a hardware alarm of its own, with its IRQ enabled
+// only on that core, at the highest priority so it preempts other ISRs
+// (their time is work). The handler reads the interrupted PC from the
+// exception frame: right after a WFE or WFI means the core was asleep.
+// The frame walk is Cortex-M only; RISC-V builds use declared idle.
+#define SAMPLE_MIN_COUNT   20        // Fewer in a window (masked sleeps) and it's not used
+
+static volatile uint32_t _samples[PICOMIMI_NUM_CORES];
+static volatile uint32_t _idle_samples[PICOMIMI_NUM_CORES];
+static int8_t _sample_alarm[PICOMIMI_NUM_CORES] = { -1, -1 };
+
+#if !defined(__riscv) && PICOMIMI_IDLE_SAMPLE_HZ > 0
+#define THUMB_WFE          0xBF20
+#define THUMB_WFI          0xBF30
+
+static volatile uint32_t* _sample_since[PICOMIMI_NUM_CORES];
+static volatile bool* _sample_waking[PICOMIMI_NUM_CORES];
+static uint32_t _sample_period_us;
+
+// frame: r0-r3, r12, lr, pc, xpsr as stacked on exception entry
+extern "C" void __not_in_flash_func(_picomimiSample)(const uint32_t* frame) {
+  uint8_t core = get_core_num();
+  uint8_t alarm = _sample_alarm[core];
+  timer_hw->intr = 1u << alarm;
+  timer_hw->alarm[alarm] = timer_hw->timerawl + _sample_period_us;
+  
+  uint16_t prev = *(const uint16_t*)(uintptr_t)((frame[6] & ~1u) - 2);
+  bool idle = prev == THUMB_WFE || prev == THUMB_WFI ||
+              *_sample_since[core] != 0 || *_sample_waking[core];
+  if (idle) _idle_samples[core]++;
+  _samples[core]++;
+}
+
+// Pick the stack the frame went on (EXC_RETURN bit 2) and tail-call the
+// handler with it; lr still holds EXC_RETURN for its return
+extern "C" __attribute__((naked, section(".time_critical.picomimi_sample_irq"))) void _picomimiSampleIrq() {
+  __asm volatile (
+    "movs r0, #4          \n"
+    "mov  r1, lr          \n"
+    "tst  r0, r1          \n"
+    "beq  1f              \n"
+    "mrs  r0, psp         \n"
+    "b    2f              \n"
+    "1:                   \n"
+    "mrs  r0, msp         \n"
+    "2:                   \n"
+    "ldr  r1, 3f          \n"
+    "bx   r1              \n"
+    ".align 2             \n"
+    "3: .word _picomimiSample \n"
+  );
+}
+
+// On the core to sample. No free alarm just means declared idle only.
+void PicomimiGovernorClass::_armSampler(uint8_t core) {
+  if (_sample_alarm[core] >= 0) return;
+  int alarm = hardware_alarm_claim_unused(false);
+  if (alarm < 0) return;
+  
+  CoreLoad& c = _cores[core];
+  c.seen_samples = _samples[core];
+  c.seen_idle_samples = _idle_samples[core];
+  c.active = true;
+  _sample_period_us = 1000000 / PICOMIMI_IDLE_SAMPLE_HZ;
+  _sample_since[core] = &c.idle_since_us;
+  _sample_waking[core] = &c.waking;
+  _sample_alarm[core] = (int8_t)alarm;
+  
+  uint32_t irq = hardware_alarm_get_irq_num(alarm);
+  irq_set_exclusive_handler(irq, _picomimiSampleIrq);
+  irq_set_priority(irq, PICO_HIGHEST_IRQ_PRIORITY);
+  hw_set_bits(&timer_hw->inte, 1u << alarm);
+  irq_set_enabled(irq, true);
+  timer_hw->alarm[alarm] = timer_hw->timerawl + _sample_period_us;
+}
+#else
+void PicomimiGovernorClass::_armSampler(uint8_t core) { (void)core; }
+#endif
+
+IdleSource PicomimiGovernorClass::getIdleSource(uint8_t core) {
+  if (core >= PICOMIMI_NUM_CORES || _sample_alarm[core] < 0) return IDLE_SOURCE_DECLARED;
+  return IDLE_SOURCE_SAMPLED;
+}
+
+// ============================================================================
+// INTERNAL - Load Calculation
+// ============================================================================
+
+// Runs on the calling core only, so it never touches the other slot
+void PicomimiGovernorClass::_account(CoreLoad& c, uint32_t now_us) {
+  // Measure user code time (time since last run() completed)
+  if (!c.first_run) {
+    uint32_t user_code_time = now_us - c.last_run_us;
+    
+    // Nothing but run() in the loop: the whole iteration was polling
+    if (user_code_time < PICOMIMI_SPIN_GAP_US && c.idle_us == 0) {
+      c.idle_total_us += now_us - c.last_entry_us;
+    }
+    
+    // Subtract any explicitly marked idle time
+    uint32_t idle_us = c.idle_us;
+    uint32_t work_time = (user_code_time > idle_us) 
+                         ? (user_code_time - idle_us) 
+                         : 0;
+    
+    // The sketch's loop: the owner's, except in SERVICE_CORE1 where
+    // core1 is the governor's own
+    uint8_t task_core = _service_mode == SERVICE_CORE1 ? 0 : _owner_core;
+    if (_deadline_us > 0 && !_task_manual && &c == &_cores[task_core]) {
+      _recordTask(work_time);
+    }
+    
+    if (_policy == POLICY_PREDICTIVE) {
+      uint32_t work = work_time > 0xFFFF ? 0xFFFF : (uint32_t)work_time;
+      if (work >= BURST_MIN_US && work >= c.typical_work_us * BURST_FACTOR) {
+        uint8_t slot = (c.burst_head + 1) % PICOMIMI_BURST_HISTORY;
+        c.burst_start_us[slot] = c.last_run_us;
+        c.burst_work_us[slot] = (uint16_t)work;
+        c.burst_mhz[slot] = (uint16_t)(_freq_khz / 1000);
+        __dmb();
+        c.burst_head = slot;
+        if (c.burst_count < PICOMIMI_BURST_HISTORY) c.burst_count++;
+        _pred_dirty = true;
+      }
+      // Bursts count towards 'typical' too, so a loop that is uniformly
+      // heavy stops looking bursty after a few iterations
+      c.typical_work_us = (c.typical_work_us * 15 + work) / 16;
+    }
+  } else {
+    _armSampler((uint8_t)(&c - _cores));   // First run() on this core
+  }
+  c.first_run = false;
+  c.active = true;
+  c.last_entry_us = now_us;
+  
+  // Reset idle accumulator for next iteration
+  c.idle_us = 0;
+}
+
+void PicomimiGovernorClass::_updateLoad() {
+  uint64_t now_us = time_us_64();
+  uint64_t period_elapsed = now_us - _period_start_us;
+  
+  if (period_elapsed < (_cfg.load_period_ms * 1000ULL)) return;
+  
+  for (uint8_t i = 0; i < PICOMIMI_NUM_CORES; i++) {
+    CoreLoad& c = _cores[i];
+    if (!c.active) continue;
+    
+    // The other core counts only while it shows signs of life: a core that
+    // stopped calling run()/idle() would otherwise read as 100% busy
+    uint32_t run_us = c.last_run_us;
+    bool alive = i == _owner_core || run_us != c.seen_run_us ||
+                 c.idle_total_us != c.seen_idle_us || c.idle_since_us != 0;
+    c.seen_run_us = run_us;
+    
+    uint32_t period_us = period_elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)period_elapsed;
+    uint32_t work_us = _idleWork(c, period_us, (uint32_t)now_us);
+    if (_sampleWork(i, period_us, work_us)) alive = true;
+    load_q16_t load = alive ? (load_q16_t)((uint64_t)work_us * PICOMIMI_LOAD_Q16(100) / period_elapsed) : 0;
+    if (load > PICOMIMI_LOAD_Q16(100)) load = PICOMIMI_LOAD_Q16(100);
+    
+    c.instant_load = load;
+    c.avg_load = policySmooth(c.avg_load, load, _cfg.load_smooth_pct);
+  }
+  
+  _instant_load = _mixLoads(_cores[0].instant_load, _cores[1].instant_load);
+  
+  // Smooth
+  _avg_load = policySmooth(_avg_load, _instant_load, _cfg.load_smooth_pct);
+  _xipSample();
+  _busSample();
+  
+  // Reset
+  _period_start_us = now_us;
+}
+
+// Work = period minus measured idle. An idle stretch still in progress
+// counts up to now; whatever of it was counted last period is taken back
+// off when it completes and lands in idle_total_us.
+uint32_t PicomimiGovernorClass::_idleWork(CoreLoad& c, uint32_t period_us, uint32_t now_us) {
+  uint32_t total = c.idle_total_us;
+  uint32_t since = c.idle_since_us;
+  uint32_t ongoing = since ? now_us - since : 0;
+  
+  // The completed part only grows, so it reads right up to a full 2^32 us
+  // window; the ongoing part can drop back when its stretch completes
+  int64_t idle = (int64_t)(uint32_t)(total - c.seen_idle_us) + (int32_t)(ongoing - c.seen_ongoing_us);
+  c.seen_idle_us = total;
+  c.seen_ongoing_us = ongoing;
+  
+  if (idle <= 0) return period_us;
+  return (uint64_t)idle >= period_us ? 0 : period_us - (uint32_t)idle;
+}
+
+void PicomimiGovernorClass::_idleBegin(CoreLoad& c) {
+  c.active = true;
+  c.idle_since_us = time_us_32() | 1;
+}
+
+// Hardware view of the same window. Declared and sampled idle overlap
+// (idle() sleeps in WFE too), so the larger share wins, never the sum.
+// A core being sampled is alive whether or not it calls run().
+bool PicomimiGovernorClass::_sampleWork(uint8_t core, uint32_t period_us, uint32_t& work_us) {
+  if (_sample_alarm[core] < 0) return false;
+  CoreLoad& c = _cores[core];
+  uint32_t idle = _idle_samples[core];   // Before the total: idle never runs ahead
+  uint32_t n = _samples[core];
+  uint32_t dn = n - c.seen_samples, didle = idle - c.seen_idle_samples;
+  c.seen_samples = n;
+  c.seen_idle_samples = idle;
+  
+  if (dn >= SAMPLE_MIN_COUNT) {
+    uint32_t busy = (uint32_t)((uint64_t)period_us * (dn - didle) / dn);
+    if (busy < work_us) work_us = busy;
+  }
+  return true;
+}
+
+// Clear 'since' first: a tick in between sees too little idle, never double.
+// The total wraps like the timestamps do, so an idle() longer than 2^32 us
+// still lands as the same delta the tick has been counting from 'since'.
+void PicomimiGovernorClass::_idleEnd(CoreLoad& c, uint64_t us) {
+  c.idle_since_us = 0;
+  __dmb();
+  c.idle_total_us += (uint32_t)us;
+}
+
+load_q16_t PicomimiGovernorClass::_mixLoads(load_q16_t l0, load_q16_t l1) {
+  bool a0 = _cores[0].active, a1 = _cores[1].active;
+  if (!a1) return l0;
+  if (!a0) return l1;
+  
+  if (_load_mix == LOAD_MIX_WEIGHTED) {
+    return (l0 * (100 - _core1_weight) + l1 * _core1_weight) / 100;
+  }
+  return l0 > l1 ? l0 : l1;
+}
+
+// ============================================================================
+// INTERNAL - Scaling
+// ============================================================================
+
+void PicomimiGovernorClass::_scale() {
+  if (_boost_on && _level >= _alias[PROFILE_PERFORMANCE]) return;
+  
+  if (_deadline_us > 0 && _task_count > 0) {
+    uint8_t target = _deadlineTarget();
+    if (target != _level) _apply(target, TRACE_DEADLINE);
+    return;
+  }
+  
+  if (_policy == POLICY_PREDICTIVE) {
+    for (uint8_t i = 0; i < PICOMIMI_NUM_CORES; i++) {
+      if (_cores[i].active) _analyzeBursts(_cores[i]);
+    }
+  }
+  
+  LoadSample s = _loadSample();
+  uint8_t target = _ops->target(_table, _opp_count, s, _policyTuning(), _pstate);
+  // Waiting on the bus: a faster clock would only wait faster
+  if (target > _level && s.efficiency_pct < _bus_min_eff) target = _level;
+  target = _capLevel(target);
+  if (_policy == POLICY_PREDICTIVE) {
+    _base_level = target;
+    _pred_raised = false;
+    _predict(time_us_32());
+    return;
+  }
+  if (target != _level) _apply(target, TRACE_LOAD);
+}
+
+// What the policy sees: both loads, the filtered temperature and the
+// range _capLevel() will clamp its answer to
+LoadSample PicomimiGovernorClass::_loadSample() {
+  LoadSample s;
+  s.instant_load = _instant_load;
+  s.avg_load = _avg_load;
+  s.temp_mc = _temp_mc;
+  s.level = _level;
+  s.floor = _capLevel(0);
+  s.ceiling = _capLevel(_opp_count - 1);
+  s.efficiency_pct = _bus_eff;
+  s.interval_ms = _cfg.scale_interval_ms;
+  return s;
+}
+
+// Phase pin, XIP cap, QoS floor, then ceiling, then the thermal cap:
+// later ones win
+uint8_t PicomimiGovernorClass::_capLevel(uint8_t level) {
+  if (_phase_depth) level = _phase_pin;
+  if (_xip_bound && level > _xip_cap) level = _xip_cap;
+  if (level < _qos_floor) level = _qos_floor;
+  if (level > _qos_ceil) level = _qos_ceil;
+  return level > _cap_level ? _cap_level : level;
+}
+
+// Look for a steady period in the last few bursts on one core
+void PicomimiGovernorClass::_analyzeBursts(CoreLoad& c) {
+  c.pred_period_us = 0;
+  
+  uint8_t n = c.burst_count;
+  uint8_t head = c.burst_head;
+  if (n < PREDICT_MIN_HITS + 1) return;
+  
+  // Intervals between consecutive bursts, newest first
+  uint32_t iv[PICOMIMI_BURST_HISTORY - 1];
+  uint32_t sorted[PICOMIMI_BURST_HISTORY - 1];
+  uint32_t max_cycles = 0;
+  uint8_t k = 0;
+  for (uint8_t i = 0; i + 1 < n; i++) {
+    uint8_t cur = (head + PICOMIMI_BURST_HISTORY - i) % PICOMIMI_BURST_HISTORY;
+    uint8_t prev = (cur + PICOMIMI_BURST_HISTORY - 1) % PICOMIMI_BURST_HISTORY;
+    iv[k] = c.burst_start_us[cur] - c.burst_start_us[prev];
+    uint32_t cycles = (uint32_t)c.burst_work_us[cur] * c.burst_mhz[cur];
+    if (cycles > max_cycles) max_cycles = cycles;
+    k++;
+  }
+  
+  // Median by insertion sort - k is at most 7
+  for (uint8_t i = 0; i < k; i++) {
+    uint32_t v = iv[i];
+    uint8_t j = i;
+    while (j > 0 && sorted[j - 1] > v) { sorted[j] = sorted[j - 1]; j--; }
+    sorted[j] = v;
+  }
+  uint32_t median = sorted[k / 2];
+  if (median == 0) return;
+  
+  uint8_t hits = 0;
+  uint32_t tol = median * PREDICT_JITTER_PCT / 100;
+  for (uint8_t i = 0; i < k; i++) {
+    uint32_t d = iv[i] > median ? iv[i] - median : median - iv[i];
+    if (d <= tol) hits++;
+  }
+  if (hits < PREDICT_MIN_HITS) return;
+  
+  // A pattern that has stopped isn't a pattern any more
+  if (time_us_32() - c.burst_start_us[head] > median * 3) return;
+  
+  // Lowest profile that fits the biggest recent burst in its share of the period
+  uint32_t want_khz = (uint32_t)((uint64_t)max_cycles * 1000 * 100 / ((uint64_t)median * PREDICT_BURST_SHARE));
+  c.pred_level = _levelAtLeast(want_khz);
+  c.pred_period_us = median;
+}
+
+// Called every run(): raise ahead of an expected burst, drop back after
+// True if it changed the level. Also sets the next time the answer
+// can change: a window opening or closing. Past that only a new burst
+// or the next decision moves anything.
+bool PicomimiGovernorClass::_predict(uint32_t now) {
+  _pred_dirty = false;
+  _pred_next_us = now + 0x7FFFFFFF;
+  if (_boost_on && _level >= _alias[PROFILE_PERFORMANCE]) return false;
+  
+  uint32_t lead = _stall_max_us * 2 > PREDICT_LEAD_US ? _stall_max_us * 2 : PREDICT_LEAD_US;
+  uint8_t target = _base_level;
+  bool raised = false;
+  int32_t edge = 0x7FFFFFFF;
+  
+  for (uint8_t i = 0; i < PICOMIMI_NUM_CORES; i++) {
+    CoreLoad& c = _cores[i];
+    if (c.pred_period_us == 0) continue;
+    
+    // Window opens 'lead' before the next burst and closes half a
+    // period later, by which time the burst has either landed (and
+    // moved 'next' on) or isn't coming
+    uint32_t next = c.burst_start_us[c.burst_head] + c.pred_period_us;
+    int32_t to_open = (int32_t)((next - lead) - now);
+    int32_t to_close = (int32_t)((next + c.pred_period_us / 2) - now);
+    if (to_open <= 0 && to_close > 0) {
+      raised = true;
+      if (c.pred_level > target) target = c.pred_level;
+    }
+    if (to_open > 0 && to_open < edge) edge = to_open;
+    else if (to_open <= 0 && to_close > 0 && to_close < edge) edge = to_close;
+  }
+  _pred_next_us = now + (uint32_t)edge;
+  
+  if (raised == _pred_raised && target == _level) return false;
+  _pred_raised = raised;
+  
+  target = _capLevel(target);
+  if (target == _level) return false;
+  _apply(target, TRACE_PREDICT);
+  return true;
+}
+
+void PicomimiGovernorClass::_recordTask(uint32_t us) {
+  _task_us = us;
+  _task_head = (_task_head + 1) % PICOMIMI_TASK_HISTORY;
+  uint64_t cycles = (uint64_t)us * (_freq_khz / 1000);
+  _task_cycles[_task_head] = cycles > UINT32_MAX ? UINT32_MAX : (uint32_t)cycles;
+  if (_task_count < PICOMIMI_TASK_HISTORY) _task_count++;
+  
+  if (us <= _deadline_us) return;
+  _deadline_misses++;
+  
+  // Missed: don't wait for the next scaling window. endTask() may be
+  // in an ISR or inside a level change, so those go through the mailbox.
+  if (_direct() && !_busy) _deadlineMove();
+  else _post(MBOX_DEADLINE, 0, 0);
+}
+
+void PicomimiGovernorClass::_deadlineMove() {
+  if (_override_on) return;
+  uint8_t target = _deadlineTarget();
+  if (target > _level) _apply(target, TRACE_DEADLINE);
+}
+
+// Cycle counts scale with 1/f, so the worst recent iteration tells us
+// how long it would take at every table frequency
+uint8_t PicomimiGovernorClass::_deadlineTarget() {
+  uint32_t worst = 0;
+  for (uint8_t i = 0; i < PICOMIMI_TASK_HISTORY; i++) {
+    if (_task_cycles[i] > worst) worst = _task_cycles[i];
+  }
+  
+  return _capLevel(policyDeadline(_table, _opp_count, worst, _deadline_us, _deadline_margin));
+}
+
+void PicomimiGovernorClass::_apply(uint8_t level, TraceReason why) {
+  if (level >= _opp_count) return;
+  bool busy = _busy;
+  _busy = true;
+  uint8_t from = _level;
+  if (!_setFreq(level)) {
+    _busy = busy;
+    return;
+  }
+  if (level != from) {
+    _accountState(time_us_64());
+    _stats[level].entries++;
+  }
+  _level = level;
+  if (level != from || why == TRACE_START) _trace(from, level, why);
+  
+  // Turbo = anything at or above the TURBO alias, if the table has one
+  bool turbo = _alias[PROFILE_TURBO] > _alias[PROFILE_PERFORMANCE] &&
+               level >= _alias[PROFILE_TURBO];
+  if (turbo && !_turbo_on) {
+    _turbo_start_ms = to_ms_since_boot(get_absolute_time());
+    _turbo_on = true;
+  } else if (!turbo) {
+    _turbo_on = false;
+  }
+  _publish();
+  _busy = busy;
+}
+
+// False if the change needs a bigger flash divider and we're in an
+// interrupt: parking the other core blocks, so only threads retune.
+// A divider left bigger than needed is safe, just a slower SCK.
+bool PicomimiGovernorClass::_setFreq(uint8_t level) {
+  const PllConfig& pll = _opps[level].pll;
+  uint32_t khz = pll.khz;
+  if (khz == _freq_khz) return true;
+  
+  uint32_t div = _flashDivFor(khz);
+  if (__get_current_exception() != 0) {
+    if (div > _flash_div) return false;
+    div = _flash_div;
+  }
+  
+  bool busy = _busy;
+  _busy = true;
+  uint32_t t0 = time_us_32();
+  vreg_voltage vr = _toVreg(_table[level].mv);
+  
+  if (khz > _freq_khz) {
+    vreg_set_voltage(vr);
+    _vreg_settle_us = _waitVreg();
+  }
+  
+  // Hooks run in the same interrupts-off window as the switch, so no ISR
+  // ever sees the new clock with old dividers. The flash divider goes up
+  // before the clock does and down after it, so SCK never overshoots;
+  // the other core is parked while it changes, as it may be in XIP.
+  uint32_t old_khz = _freq_khz;
+  bool retune = div != _flash_div;
+  uint32_t rx = retune ? _flashRxFor(div) : _flash_rx;
+  if (retune) _parkOtherCore();
+  uint32_t irq = save_and_disable_interrupts();
+  if (div > _flash_div) _setFlashDiv(div, rx);
+  _setSysPll(pll);
+  if (div < _flash_div) _setFlashDiv(div, rx);
+  for (uint8_t i = 0; i < PICOMIMI_MAX_CLOCK_HOOKS; i++) {
+    if (_hooks[i]) _hooks[i](old_khz, khz, _hook_ctx[i]);
+  }
+  restore_interrupts(irq);
+  if (retune) {
+    _flash_div = div;
+    _flash_rx = rx;
+    _resumeOtherCore();
+  }
+  
+  if (khz < _freq_khz) vreg_set_voltage(vr);
+  _freq_khz = khz;
+  
+  _stall_last_us = time_us_32() - t0;
+  if (_stall_last_us > _stall_max_us) _stall_max_us = _stall_last_us;
+  _transitions++;
+  _busy = busy;
+  return true;
+}
+
+// Smallest divider that keeps SCK at or under the limit
+uint32_t PicomimiGovernorClass::_flashDivFor(uint32_t khz) {
+  if (_flash_max_khz == 0) return _flash_div;
+  if (_service_mode == SERVICE_TIMER && _opp_count) khz = _table[_opp_count - 1].khz;
+  uint32_t div = (khz + _flash_max_khz - 1) / _flash_max_khz;
+  if (div < FLASH_MIN_DIV) div = FLASH_MIN_DIV;
+#if !PICO_RP2350
+  div = (div + 1) & ~1u;        // SSI BAUDR must be even
+#endif
+  return div;
+}
+
+// RP2350 RXDELAY counts half clk_sys cycles. Boot picked it for the boot
+// clock; what it stands for is a fixed time (pad round trip plus the
+// flash's clock-to-data), so keep that time for the fastest clock using
+// this divider. Slower clocks in the band sample later, still inside
+// the SCK period the cap allows.
+uint32_t PicomimiGovernorClass::_flashRxFor(uint32_t div) {
+#if PICO_RP2350
+  uint32_t top = 0;
+  for (uint8_t i = 0; i < _opp_count; i++) {
+    if (_flashDivFor(_table[i].khz) == div && _table[i].khz > top) top = _table[i].khz;
+  }
+  if (top == 0 || _flash_rx0_khz == 0) return _flash_rx0;
+  uint32_t rx = (_flash_rx0 * top + _flash_rx0_khz - 1) / _flash_rx0_khz;
+  if (rx > 2 * div - 1) rx = 2 * div - 1;
+  if (rx > (QMI_M0_TIMING_RXDELAY_BITS >> QMI_M0_TIMING_RXDELAY_LSB)) rx = QMI_M0_TIMING_RXDELAY_BITS >> QMI_M0_TIMING_RXDELAY_LSB;
+  return rx;
+#else
+  (void)div;
+  return 0;
+#endif
+}
+
+// Moves the divider to what the current clock needs, outside a clock
+// change: at begin() and when setFlashClock() changes the cap
+void PicomimiGovernorClass::_retuneFlash() {
+  if (__get_current_exception() != 0) return;
+  uint32_t div = _flashDivFor(_freq_khz);
+  if (div == _flash_div) return;
+  uint32_t rx = _flashRxFor(div);
+  _parkOtherCore();
+  uint32_t irq = save_and_disable_interrupts();
+  _setFlashDiv(div, rx);
+  restore_interrupts(irq);
+  _flash_div = div;
+  _flash_rx = rx;
+  _resumeOtherCore();
+}
+
+// The lowest level whose flash clock is near the best any level gets:
+// above it a flash-bound loop gains little for the extra voltage
+void PicomimiGovernorClass::_xipCapUpdate() {
+  uint32_t best = 0;
+  for (uint8_t i = 0; i < _opp_count; i++) {
+    uint32_t sck = _table[i].khz / _flashDivFor(_table[i].khz);
+    if (sck > best) best = sck;
+  }
+  _xip_cap = _opp_count - 1;
+  for (uint8_t i = 0; i < _opp_count; i++) {
+    uint32_t sck = _table[i].khz / _flashDivFor(_table[i].khz);
+    if (sck * 100 >= best * (100 - XIP_SCK_SLACK_PCT)) { _xip_cap = i; break; }
+  }
+}
+
+// Counters read hit first so a window never shows more hits than accesses
+void PicomimiGovernorClass::_xipSample() {
+  uint32_t hit = xip_ctrl_hw->ctr_hit;
+  uint32_t acc = xip_ctrl_hw->ctr_acc;
+  xip_ctrl_hw->ctr_hit = 0;
+  xip_ctrl_hw->ctr_acc = 0;
+  _xip_hit = hit;
+  _xip_acc = acc;
+  _xip_bound = _xip_limit && acc >= XIP_MIN_ACCESSES &&
+               (uint64_t)hit * 100 < (uint64_t)acc * _xip_limit;
+}
+
+// Counters saturate at 24 bits, so the ratio stays usable even in a
+// window long enough to fill the access counts
+void PicomimiGovernorClass::_busSample() {
+  if (!_bus_min_eff) return;
+  uint32_t acc = busctrl_hw->counter[0].value + busctrl_hw->counter[2].value;
+  uint32_t contested = busctrl_hw->counter[1].value + busctrl_hw->counter[3].value;
+  for (uint8_t i = 0; i < 4; i++) busctrl_hw->counter[i].value = 0;
+  if (contested > acc) contested = acc;
+  _bus_eff = acc >= BUS_MIN_ACCESSES ? (uint8_t)(100 - (uint64_t)contested * 100 / acc) : 100;
+}
+
+// Our own core1 doesn't answer the core's idleOtherCore(); both cores
+// registered as lockout victims in SERVICE_CORE1 instead
+void PicomimiGovernorClass::_parkOtherCore() {
+  if (_init && _service_mode == SERVICE_CORE1) multicore_lockout_start_blocking();
+  else rp2040.idleOtherCore();
+}
+
+void PicomimiGovernorClass::_resumeOtherCore() {
+  if (_init && _service_mode == SERVICE_CORE1) multicore_lockout_end_blocking();
+  else rp2040.resumeOtherCore();
+}
+
+// set_sys_clock_pll() without the parts we don't need: clk_sys is parked
+// on the 48 MHz USB PLL (glitchless, via clk_ref) while pll_sys changes,
+// and if the VCO is already right only the post dividers are rewritten.
+void PicomimiGovernorClass::_setSysPll(const PllConfig& pll) {
+  uint32_t hz = pll.khz * 1000;
+  bool same_vco = (pll_sys->cs & PLL_CS_LOCK_BITS) &&
+                  (pll_sys->cs & PLL_CS_REFDIV_BITS) == PLL_COMMON_REFDIV &&
+                  (pll_sys->fbdiv_int & PLL_FBDIV_INT_BITS) * PLL_REF_KHZ == pll.vco_khz;
+  
+  clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX,
+                  CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB,
+                  USB_CLK_KHZ * 1000, USB_CLK_KHZ * 1000);
+  
+  if (same_vco) {
+    pll_sys->prim = ((uint32_t)pll.postdiv1 << PLL_PRIM_POSTDIV1_LSB) |
+                    ((uint32_t)pll.postdiv2 << PLL_PRIM_POSTDIV2_LSB);
+  } else {
+    pll_init(pll_sys, PLL_COMMON_REFDIV, pll.vco_khz * 1000, pll.postdiv1, pll.postdiv2);
+  }
+  
+  clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX,
+                  CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS, hz, hz);
+  if (_peri_clock == PERI_CLOCK_FOLLOW_SYS) {
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLK_SYS, hz, hz);
+  }
+}
+
+void PicomimiGovernorClass::_applyPeriClock() {
+  if (_peri_clock == PERI_CLOCK_FIXED_USB) {
+    uint32_t usb_hz = USB_CLK_KHZ * 1000;
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB, usb_hz, usb_hz);
+    clock_configure(clk_adc, 0, CLOCKS_CLK_ADC_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB, usb_hz, usb_hz);
+    clock_configure(clk_usb, 0, CLOCKS_CLK_USB_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB, usb_hz, usb_hz);
+  } else {
+    uint32_t hz = clock_get_hz(clk_sys);
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLK_SYS, hz, hz);
+  }
+}
+
+// Returns how long the regulator took to come back into regulation
+uint32_t PicomimiGovernorClass::_waitVreg() {
+  uint32_t t0 = time_us_32();
+#if PICO_RP2350
+  // vreg_set_voltage() waits for POWMAN to apply the change, but there's
+  // no regulation-OK flag to poll afterwards, so keep the full margin.
+  busy_wait_us_32(VREG_SETTLE_MAX_US);
+#else
+  busy_wait_us_32(VREG_SETTLE_MIN_US);
+  while (!(vreg_and_chip_reset_hw->vreg & VREG_AND_CHIP_RESET_VREG_ROK_BITS) &&
+         time_us_32() - t0 < VREG_SETTLE_MAX_US) {
+    tight_loop_contents();
+  }
+#endif
+  return time_us_32() - t0;
+}
+
+// ============================================================================
+// INTERNAL - Thermal
+// ============================================================================
+
+// Runs where the decision does (the decide interrupt in SERVICE_TIMER).
+// Stays off the ADC while setTempSampling() is reprogramming it.
+void PicomimiGovernorClass::_sampleTemp() {
+  _temp_reading = true;
+  __dmb();
+  if (!_temp_reconfig) {
+    int32_t mc = policyTempFilter(_temp_filter, _readTempMc());
+    _temp_slope_mc = policyTempSlope(_temp_filter, _cfg.scale_interval_ms);
+    _temp_mc = mc;
+    _temp = mc / 1000.0f;
+  }
+  __dmb();
+  _temp_reading = false;
+}
+
+void PicomimiGovernorClass::_thermal() {
+  int32_t mc = _temp_mc;
+  int32_t ahead_mc = mc + _temp_slope_mc * (THERMAL_LOOKAHEAD_MS / 1000);
+  if (ahead_mc < mc) ahead_mc = mc;
+  
+  bool was = _throttled;
+  uint8_t from = _level;
+  
+  uint32_t cap_khz = policyPid(_pid, _temp, _cfg.scale_interval_ms / 1000.0f,
+                               _table[0].khz, _table[_opp_count - 1].khz);
+  uint32_t crit_khz = _table[_alias[PROFILE_POWERSAVE]].khz;
+  if (ahead_mc >= (int32_t)(THERMAL_CRITICAL * 1000.0f) && cap_khz > crit_khz) {
+    cap_khz = crit_khz;
+    policyPidReset(_pid, crit_khz);   // Climb back from here, not from the top
+  }
+  
+  _cap_level = policyAtMost(_table, _opp_count, cap_khz);
+  _throttled = _cap_level < _opp_count - 1;
+  if (_throttled && !was) _throttle_count++;
+  if (_level > _cap_level) _apply(_cap_level, TRACE_THERMAL);
+  
+  // Throttle state changes with no level change still get a record
+  if (_throttled != was && _level == from) _trace(from, from, TRACE_THERMAL);
+}
+
+// Median of recent raw readings, so one noisy conversion can't throttle
+int32_t PicomimiGovernorClass::_readTempMc() {
+  uint16_t v[PICOMIMI_TEMP_SAMPLES];
+  uint8_t n = 0;
+  
+  if (_temp_mode == TEMP_SAMPLE_DMA) {
+    if (!dma_channel_is_busy(_adc_dma)) _adcStart();   // Count ran out; restart in step
+    n = _adcRecent(ADC_TEMPERATURE_CHANNEL_NUM, v, PICOMIMI_TEMP_SAMPLES);
+    if (n == 0) return (int32_t)(_temp * 1000.0f);
+  } else {
+    // The mux goes back to whatever was selected, and one conversion on
+    // it leaves that channel's result in place for a read we cut into
+    uint32_t was = adc_get_selected_input();
+    adc_select_input(ADC_TEMPERATURE_CHANNEL_NUM);
+    for (n = 0; n < TEMP_BURST; n++) v[n] = adc_read();
+    adc_select_input(was);
+    (void)adc_read();
+  }
+  return policyTempMc(policyMedian(v, n));
+}
+
+bool PicomimiGovernorClass::_adcStart() {
+  if (_adc_dma < 0) _adc_dma = dma_claim_unused_channel(false);
+  if (_adc_dma < 0) return false;
+  
+  uint8_t mask = _adc_inputs | (1u << ADC_TEMPERATURE_CHANNEL_NUM);
+  _adc_count = 0;
+  for (uint8_t i = 0; i <= ADC_TEMPERATURE_CHANNEL_NUM; i++) {
+    if (mask & (1u << i)) _adc_order[_adc_count++] = i;
+  }
+  
+  adc_run(false);
+  dma_channel_abort(_adc_dma);
+  adc_fifo_setup(true, true, 1, false, false);
+  adc_fifo_drain();
+  adc_select_input(_adc_order[0]);   // Round robin steps up from here
+  adc_set_round_robin(mask);
+  float div = (float)ADC_CLOCK_HZ / ((float)_adc_rate_hz * _adc_count) - 1.0f;
+  adc_set_clkdiv(div > 0 ? div : 0);
+  
+  dma_channel_config cfg = dma_channel_get_default_config(_adc_dma);
+  channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+  channel_config_set_read_increment(&cfg, false);
+  channel_config_set_write_increment(&cfg, true);
+  channel_config_set_ring(&cfg, true, ADC_RING_BITS);
+  channel_config_set_dreq(&cfg, DREQ_ADC);
+  dma_channel_configure(_adc_dma, &cfg, _adc_ring, &adc_hw->fifo, ADC_DMA_COUNT, true);
+  adc_run(true);
+  return true;
+}
+
+void PicomimiGovernorClass::_adcStop() {
+  if (_adc_dma < 0) return;
+  adc_run(false);
+  dma_channel_abort(_adc_dma);
+  dma_channel_unclaim(_adc_dma);
+  _adc_dma = -1;
+  adc_set_round_robin(0);
+  adc_fifo_setup(false, false, 0, false, false);
+  adc_fifo_drain();
+}
+
+// Sample k of the stream is input _adc_order[k % count], at ring slot
+// k % RING. The newest slot may be mid-write, the rest are settled.
+uint8_t PicomimiGovernorClass::_adcRecent(uint8_t input, uint16_t* out, uint8_t max) {
+  uint32_t k = ADC_DMA_COUNT - (dma_channel_hw_addr(_adc_dma)->transfer_count & ADC_DMA_COUNT);
+  uint32_t back = k < PICOMIMI_ADC_RING ? k : PICOMIMI_ADC_RING - 1;
+  uint8_t n = 0;
+  for (uint32_t j = 1; j <= back && n < max; j++) {
+    uint32_t s = k - j;
+    if (_adc_order[s % _adc_count] == input) out[n++] = _adc_ring[s % PICOMIMI_ADC_RING] & 0x0FFF;
+  }
+  return n;
+}
+
+// ============================================================================
+// INTERNAL - Timeouts
+// ============================================================================
+
+void PicomimiGovernorClass::_timeouts() {
+  uint32_t now = to_ms_since_boot(get_absolute_time());
+  
+  if (_turbo_on && (now - _turbo_start_ms >= _cfg.turbo_max_ms)) {
+    _turbo_on = false;
+    if (_level >= _alias[PROFILE_TURBO]) _apply(_alias[PROFILE_PERFORMANCE], TRACE_TIMEOUT);
+  }
+  
+  if (_boost_on && (now - _boost_start_ms >= _cfg.boost_ms)) _boost_on = false;
+  
+  if (_qos_next_expiry_ms && (int32_t)(now - _qos_next_expiry_ms) >= 0) {
+    uint32_t irq = _lockQos();
+    _qosAggregate(now);
+    _unlockQos(irq);
+  }
+  
+  if (_override_on && _override_end_ms > 0 && now >= _override_end_ms) {
+    _override_on = false;
+    _override_end_ms = 0;
+    _override_expired = true;
+  }
+}
+
+// ============================================================================
+// INTERNAL - WFI, Sleep & Voltage
+// ============================================================================
+
+void PicomimiGovernorClass::_wfi() {
+  CoreLoad& c = _cores[get_core_num()];
+  uint32_t irq = save_and_disable_interrupts();
+  uint32_t t0 = time_us_32();
+  c.idle_since_us = t0 | 1;
+  __wfi();
+  _idleEnd(c, time_us_32() - t0);
+  c.waking = true;
+  restore_interrupts(irq);
+  c.waking = false;
+}
+
+// One sleep with PRIMASK set: a pending interrupt still wakes the core
+// (WFE via SEVONPEND), but its handler only runs after the idle time is
+// booked, so ISR time counts as work. 'waking' lets the idle sampler,
+// which runs first, see that it was the one that woke a sleep.
+void PicomimiGovernorClass::_sleepMasked(CoreLoad& c) {
+  uint32_t irq = save_and_disable_interrupts();
+  uint32_t t0 = time_us_32();
+  c.idle_since_us = t0 | 1;
+  __wfe();
+  _idleEnd(c, time_us_32() - t0);
+  c.waking = true;
+  restore_interrupts(irq);
+  c.waking = false;
+}
+
+void PicomimiGovernorClass::_spinUntil(CoreLoad& c, uint64_t target_us) {
+  uint32_t t0 = time_us_32();
+  _idleBegin(c);
+  busy_wait_until(from_us_since_boot(target_us));
+  _idleEnd(c, time_us_32() - t0);
+}
+
+// Alarm IRQ runs on the core that owns the default pool, so it also
+// sends an event to wake the other core if that one is the sleeper.
+static int64_t _wakeAlarm(alarm_id_t id, void* fired) {
+  (void)id;
+  *(volatile bool*)fired = true;
+  __sev();
+  return 0;
+}
+
+void PicomimiGovernorClass::_idleFor(uint64_t us) {
+  uint64_t target = time_us_64() + us;
+  
+  if (_idle_mode == IDLE_DEEP && us >= getDeepBreakEvenUs() && _deepOk()) {
+    _deepIdle(target);
+    return;
+  }
+  
+  // Long windows on a single active core can drop the clock as well;
+  // with core1 running we'd be slowing its work down too. A manual
+  // override or a running phase hint outranks it, and the low end is
+  // clamped like any decision.
+  uint8_t low = _capLevel(0);
+  bool downclock = _init && _downclock_ms > 0 && us >= _downclock_ms * 1000ULL &&
+                   get_core_num() == _owner_core &&
+                   !_cores[_owner_core ^ 1].active && low < _level &&
+                   !_override_on && _phase_depth == 0;
+  
+  if (!downclock) {
+    _sleepUntil(target);
+    return;
+  }
+  
+  // A real level change both ways, so residency, energy and the trace
+  // see it. _busy keeps decisions off it meanwhile, and the turbo clock
+  // carries on as if we'd never left.
+  bool busy = _busy;
+  _busy = true;
+  uint8_t level = _level;
+  bool turbo = _turbo_on;
+  uint32_t turbo_start = _turbo_start_ms;
+  _apply(low, TRACE_IDLE);
+  _sleepUntil(target);
+  _apply(level, TRACE_IDLE);
+  _turbo_on = turbo;
+  _turbo_start_ms = turbo_start;
+  _busy = busy;
+}
+
+// Thread code on the scaling core, with the other core quiet: nothing
+// else may run at a clock it didn't expect
+bool PicomimiGovernorClass::_deepOk() {
+  return _init && _direct() && _service_mode != SERVICE_CORE1 && !_cores[_owner_core ^ 1].active;
+}
+
+// The alarm is set early by the exit time, so the level is back by the
+// deadline. _busy keeps the tick from changing levels with pll_sys off.
+void PicomimiGovernorClass::_deepIdle(uint64_t target_us) {
+  bool busy = _busy;
+  _busy = true;
+  uint64_t t0 = time_us_64();
+  _deepEnter();
+  uint64_t t1 = time_us_64();
+  if (target_us > t1 + _deep_exit_us) _sleepUntil(target_us - _deep_exit_us);
+  uint64_t t2 = time_us_64();
+  _deepExit();
+  uint64_t t3 = time_us_64();
+  
+  uint32_t entry = (uint32_t)(t1 - t0), exit = (uint32_t)(t3 - t2);
+  _deep_entry_us = _deep_count ? (_deep_entry_us * 7 + entry) / 8 : entry;
+  _deep_exit_us = _deep_count ? (_deep_exit_us * 7 + exit) / 8 : exit;
+  _deep_count++;
+  _busy = busy;
+  
+  if (t3 < target_us) _spinUntil(_cores[get_core_num()], target_us);
+}
+
+// clk_ref already runs from the crystal on arduino-pico, so clk_sys
+// switches to it glitchlessly. Clock hooks see the crystal frequency.
+void PicomimiGovernorClass::_deepEnter() {
+  uint32_t hz = XOSC_KHZ * 1000;
+  uint32_t irq = save_and_disable_interrupts();
+  clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLK_REF, 0, hz, hz);
+  if (_peri_clock == PERI_CLOCK_FOLLOW_SYS) {
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLK_SYS, hz, hz);
+  }
+  pll_deinit(pll_sys);
+  for (uint8_t i = 0; i < PICOMIMI_MAX_CLOCK_HOOKS; i++) {
+    if (_hooks[i]) _hooks[i](_freq_khz, XOSC_KHZ, _hook_ctx[i]);
+  }
+  restore_interrupts(irq);
+  vreg_set_voltage(_toVreg(_table[0].mv));
+}
+
+// Voltage first, then relock; _setSysPll() sees the PLL unlocked and
+// does a full pll_init()
+void PicomimiGovernorClass::_deepExit() {
+  vreg_set_voltage(_toVreg(_table[_level].mv));
+  _waitVreg();
+  uint32_t irq = save_and_disable_interrupts();
+  _setSysPll(_opps[_level].pll);
+  for (uint8_t i = 0; i < PICOMIMI_MAX_CLOCK_HOOKS; i++) {
+    if (_hooks[i]) _hooks[i](XOSC_KHZ, _freq_khz, _hook_ctx[i]);
+  }
+  restore_interrupts(irq);
+}
+
+void PicomimiGovernorClass::_sleepUntil(uint64_t target_us) {
+  CoreLoad& c = _cores[get_core_num()];
+  uint64_t now = time_us_64();
+  uint32_t lat = _wake_lat_us;
+  
+  // Too short to be worth arming an alarm - spin it out
+  if (now >= target_us || target_us - now < (uint64_t)_min_sleep_us + lat) {
+    _spinUntil(c, target_us);
+    return;
+  }
+  
+  // Wake early by the expected latency, spin the remainder
+  uint64_t alarm_us = target_us - lat;
+  volatile bool fired = false;
+  alarm_id_t id = add_alarm_at(from_us_since_boot(alarm_us), _wakeAlarm, (void*)&fired, false);
+  if (id <= 0) {
+    _spinUntil(c, target_us);
+    return;
+  }
+  
+  // Masked interrupts must still wake WFE; put SCR back for the sketch
+  uint32_t scr = scb_hw->scr;
+  hw_set_bits(&scb_hw->scr, SCR_SEVONPEND_BITS);
+  while (!fired) _sleepMasked(c);
+  scb_hw->scr = scr;
+  
+  uint64_t woke = time_us_64();
+  uint32_t measured = (uint32_t)(woke - alarm_us);
+  _wake_lat_us = lat == 0 ? measured : (lat * 7 + measured) / 8;
+  if (measured > _wake_lat_max_us) _wake_lat_max_us = measured;
+  
+  if (woke < target_us) _spinUntil(c, target_us);
+}
+
+vreg_voltage PicomimiGovernorClass::_toVreg(uint32_t mv) {
+  if (mv <= 850) return VREG_VOLTAGE_0_85;
+  if (mv <= 900) return VREG_VOLTAGE_0_90;
+  if (mv <= 950) return VREG_VOLTAGE_0_95;
+  if (mv <= 1000) return VREG_VOLTAGE_1_00;
+  if (mv <= 1050) return VREG_VOLTAGE_1_05;
+  if (mv <= 1100) return VREG_VOLTAGE_1_10;
+  if (mv <= 1150) return VREG_VOLTAGE_1_15;
+  if (mv <= 1200) return VREG_VOLTAGE_1_20;
+  if (mv <= 1250) return VREG_VOLTAGE_1_25;
+  return VREG_VOLTAGE_1_30;
+}
+
+// ============================================================================
+// MANUAL MODE
+// ============================================================================
+
+// Commands, matched on the first word. A word matches when it is a
+// prefix of name at least min_len long, so "bal" and "balanced" both
+// work. Two-word names match both words in full, and sit ahead of their
+// first word. Entries with no usage line are aliases and stay out of the help.
+struct SerialCommand {
+  const char* name;
+  uint8_t min_len;
+  void (PicomimiGovernorClass::*handler)(const char* arg);
+  const char* usage;
+  const char* help;
+};
+
+const SerialCommand PicomimiGovernorClass::_commands[] = {
+  { "gov",         3, &PicomimiGovernorClass::_cmdHelp,    nullptr,       nullptr },
+  { "help",        4, &PicomimiGovernorClass::_cmdHelp,    nullptr,       nullptr },
+  { "?",           1, &PicomimiGovernorClass::_cmdHelp,    nullptr,       nullptr },
+  { "status",      1, &PicomimiGovernorClass::_cmdStatus,  "status",      "Show status" },
+  { "auto",        1, &PicomimiGovernorClass::_cmdAuto,    "auto",        "Auto scaling" },
+  { "turbo",       5, &PicomimiGovernorClass::_cmdTurbo,   "turbo [s]",   "Turbo for N sec" },
+  { "save",        4, &PicomimiGovernorClass::_cmdSave,    "save [s]",    "Powersave for N sec" },
+  { "powersave",   5, &PicomimiGovernorClass::_cmdSave,    nullptr,       nullptr },
+  { "balanced",    3, &PicomimiGovernorClass::_cmdBal,     "balanced [s]", "Balanced mode" },
+  { "performance", 4, &PicomimiGovernorClass::_cmdPerf,    "perf [s]",    "Performance mode" },
+  { "ultra",       5, &PicomimiGovernorClass::_cmdUltra,   "ultra",       "Ultra-low power" },
+  { "low",         3, &PicomimiGovernorClass::_cmdUltra,   nullptr,       nullptr },
+  { "opps",        4, &PicomimiGovernorClass::_cmdOpps,    "opps",        "List operating points" },
+  { "opp",         3, &PicomimiGovernorClass::_cmdOpp,     "opp <n>",     "Pin operating point n" },
+  { "cal",         3, &PicomimiGovernorClass::_cmdCal,     "cal [clear]", "Calibrate undervolt curve" },
+  { "stats",       5, &PicomimiGovernorClass::_cmdStats,   "stats [reset]", "Residency and energy per OPP" },
+  { "trace",       5, &PicomimiGovernorClass::_cmdTrace,   "trace [clear]", "Dump decision trace (binary)" },
+  { "get",         3, &PicomimiGovernorClass::_cmdGet,     "get",         "List tunables" },
+  { "set save",    8, &PicomimiGovernorClass::_cmdSetSave, "set save",    "Store tunables in flash" },
+  { "set clear",   9, &PicomimiGovernorClass::_cmdSetClear, "set clear",  "Forget stored tunables" },
+  { "set",         3, &PicomimiGovernorClass::_cmdSet,     "set <k> <v>", "Change a tunable" },
+  { "policy",      3, &PicomimiGovernorClass::_cmdPolicy,  "policy [name]", "Show or pick the scaling policy" },
+  { "phases",      5, &PicomimiGovernorClass::_cmdPhases,  "phases [reset]", "What each phase hint learned" },
+};
+
+static bool _parseUint(const char* s, uint32_t& out) {
+  if (*s < '0' || *s > '9') return false;
+  uint32_t v = 0;
+  for (; *s >= '0' && *s <= '9'; s++) {
+    if (v > 429496728) return false;   // Next digit would overflow
+    v = v * 10 + (*s - '0');
+  }
+  if (*s != '\0') return false;
+  out = v;
+  return true;
+}
+
+// Optional seconds argument: def when absent, false when malformed
+static bool _argSeconds(const char* arg, uint32_t def, uint32_t& out) {
+  if (*arg == '\0') { out = def; return true; }
+  return _parseUint(arg, out);
+}
+
+// Bytes accumulate into a fixed line buffer, lowercased; a line that
+// doesn't fit is dropped whole rather than run truncated
+void PicomimiGovernorClass::_handleSerial() {
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c == '\n' || c == '\r') {
+      if (_cmd_overflow) Serial.println(F("[GOV] Line too long"));
+      else if (_cmd_len > 0) {
+        _cmd[_cmd_len] = '\0';
+        _dispatch(_cmd);
+      }
+      _cmd_len = 0;
+      _cmd_overflow = false;
+    } else if (_cmd_len + 1 >= PICOMIMI_CMD_MAX) {
+      _cmd_overflow = true;
+    } else if (c == ' ' || c == '\t') {
+      // Leading and repeated blanks collapse, so args are one space apart
+      if (_cmd_len > 0 && _cmd[_cmd_len - 1] != ' ') _cmd[_cmd_len++] = ' ';
+    } else {
+      _cmd[_cmd_len++] = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+    }
+  }
+}
+
+void PicomimiGovernorClass::_dispatch(char* line) {
+  uint8_t len = strlen(line);
+  if (len > 0 && line[len - 1] == ' ') line[--len] = '\0';
+  if (len == 0) return;
+  
+  char* arg = strchr(line, ' ');
+  uint8_t word = arg ? arg - line : len;
+  arg = arg ? arg + 1 : line + len;
+  
+  for (const SerialCommand& cmd : _commands) {
+    uint8_t n = strlen(cmd.name);
+    if (strchr(cmd.name, ' ')) {
+      if (strncmp(line, cmd.name, n) != 0 || (line[n] != '\0' && line[n] != ' ')) continue;
+      (this->*cmd.handler)(line[n] ? line + n + 1 : line + n);
+      return;
+    }
+    if (word < cmd.min_len || word > n) continue;
+    if (strncmp(line, cmd.name, word) != 0) continue;
+    (this->*cmd.handler)(arg);
+    return;
+  }
+  _cmdUnknown();
+}
+
+void PicomimiGovernorClass::_cmdUnknown() { Serial.println(F("[GOV] Unknown. Type 'gov'")); }
+
+void PicomimiGovernorClass::_cmdHelp(const char* arg) { (void)arg; _printHelp(); }
+void PicomimiGovernorClass::_cmdStatus(const char* arg) { (void)arg; _printStatus(); }
+void PicomimiGovernorClass::_cmdAuto(const char* arg) { (void)arg; setAuto(); Serial.println(F("[GOV] Auto")); }
+
+void PicomimiGovernorClass::_cmdTurbo(const char* arg) {
+  uint32_t sec;
+  if (!_argSeconds(arg, 30, sec)) return _cmdUnknown();
+  if (sec > 3600) sec = 3600;
+  setTurbo(sec);
+  Serial.print(F("[GOV] TURBO ")); Serial.print(sec); Serial.println(F("s"));
+}
+
+void PicomimiGovernorClass::_cmdSave(const char* arg) {
+  uint32_t sec;
+  if (!_argSeconds(arg, 60, sec)) return _cmdUnknown();
+  setPowersave(sec);
+  Serial.print(F("[GOV] POWERSAVE ")); Serial.print(sec); Serial.println(F("s"));
+}
+
+void PicomimiGovernorClass::_cmdBal(const char* arg) {
+  uint32_t sec;
+  if (!_argSeconds(arg, 0, sec)) return _cmdUnknown();
+  setProfile(PROFILE_BALANCED, sec);
+  Serial.println(F("[GOV] BALANCED"));
+}
+
+void PicomimiGovernorClass::_cmdPerf(const char* arg) {
+  uint32_t sec;
+  if (!_argSeconds(arg, 0, sec)) return _cmdUnknown();
+  setProfile(PROFILE_PERFORMANCE, sec);
+  Serial.println(F("[GOV] PERFORMANCE"));
+}
+
+void PicomimiGovernorClass::_cmdUltra(const char* arg) {
+  (void)arg;
+  setProfile(PROFILE_ULTRA_LOW, 0);
+  Serial.println(F("[GOV] ULTRA_LOW"));
+}
+
+void PicomimiGovernorClass::_cmdOpps(const char* arg) { (void)arg; _printOpps(); }
+
+void PicomimiGovernorClass::_cmdOpp(const char* arg) {
+  uint32_t level;
+  if (!_parseUint(arg, level) || level >= _opp_count) {
+    Serial.println(F("[GOV] No such OPP"));
+    return;
+  }
+  setOpp(level, 0);
+  Serial.print(F("[GOV] OPP ")); Serial.print(level);
+  Serial.print(F(" @ ")); Serial.print(getOppFreqMHz(level)); Serial.println(F(" MHz"));
+}
+
+void PicomimiGovernorClass::_cmdCal(const char* arg) {
+  if (!strcmp(arg, "clear")) {
+    clearCalibration();
+    Serial.println(F("[GOV] Calibration cleared"));
+  } else if (*arg == '\0') {
+    Serial.println(F("[GOV] Calibrating..."));
+    Serial.println(calibrate() ? F("[GOV] Calibration saved") : F("[GOV] Calibration not saved"));
+  } else _cmdUnknown();
+}
+
+void PicomimiGovernorClass::_cmdStats(const char* arg) {
+  if (!strcmp(arg, "reset")) { resetStats(); Serial.println(F("[GOV] Stats reset")); }
+  else if (*arg == '\0') _printStats();
+  else _cmdUnknown();
+}
+
+void PicomimiGovernorClass::_cmdTrace(const char* arg) {
+  if (!strcmp(arg, "clear")) { clearTrace(); Serial.println(F("[GOV] Trace cleared")); }
+  else if (*arg == '\0') dumpTrace(Serial);
+  else _cmdUnknown();
+}
+
+void PicomimiGovernorClass::_cmdGet(const char* arg) { (void)arg; _printTunables(); }
+
+void PicomimiGovernorClass::_cmdSetSave(const char* arg) {
+  (void)arg;
+  Serial.println(saveTunables() ? F("[GOV] Tunables saved") : F("[GOV] Tunables not saved"));
+}
+
+void PicomimiGovernorClass::_cmdSetClear(const char* arg) {
+  (void)arg;
+  clearTunables();
+  Serial.println(F("[GOV] Saved tunables cleared"));
+}
+
+void PicomimiGovernorClass::_cmdSet(const char* arg) {
+  // "<name> <value>": split in a copy, the line buffer stays intact
+  char name[PICOMIMI_CMD_MAX];
+  const char* sp = strchr(arg, ' ');
+  uint32_t value;
+  if (!sp || !_parseUint(sp + 1, value)) {
+    Serial.println(F("[GOV] Usage: set <name> <value>"));
+    return;
+  }
+  memcpy(name, arg, sp - arg);
+  name[sp - arg] = '\0';
+  if (_setTunable(name, value)) {
+    Serial.print(F("[GOV] ")); Serial.print(name); Serial.print(F(" = ")); Serial.println(value);
+  } else Serial.println(F("[GOV] Bad name or value. Type 'get'"));
+}
+
+void PicomimiGovernorClass::_cmdPhases(const char* arg) {
+  if (!strcmp(arg, "reset")) { resetPhases(); Serial.println(F("[GOV] Phases reset")); }
+  else if (*arg == '\0') _printPhases();
+  else _cmdUnknown();
+}
+
+void PicomimiGovernorClass::_cmdPolicy(const char* arg) {
+  if (*arg != '\0') {
+    uint8_t i = 0;
+    while (i < POLICY_CUSTOM && strcmp(arg, BUILTIN_POLICIES[i].name)) i++;
+    if (i == POLICY_CUSTOM) {
+      Serial.println(F("[GOV] Unknown policy"));
+      return;
+    }
+    setPolicy((ScalingPolicy)i);
+  }
+  Serial.print(F("[GOV] Policy: ")); Serial.println(_ops->name);
+  Serial.print(F("[GOV] Built-in:"));
+  for (uint8_t i = 0; i < POLICY_CUSTOM; i++) {
+    Serial.print(' '); Serial.print(BUILTIN_POLICIES[i].name);
+  }
+  Serial.println();
+}
+
+void PicomimiGovernorClass::_printHelp() {
+  Serial.println(F("\n╔══════════════════════════════════════════╗"));
+  Serial.println(F("║  PICOMIMI CPU GOVERNOR                   ║"));
+  Serial.println(F("╚══════════════════════════════════════════╝\n"));
+  Serial.println(F("Commands:"));
+  for (const SerialCommand& cmd : _commands) {
+    if (!cmd.usage) continue;
+    Serial.print(F("  ")); Serial.print(cmd.usage);
+    for (uint8_t i = strlen(cmd.usage); i < 14; i++) Serial.print(' ');
+    Serial.println(cmd.help);
+  }
+  Serial.println();
+  Serial.println(F("Tip: Use PicomimiGov.idle(ms) instead of delay()"));
   Serial.println(F("     for accurate load tracking.\n"));
 }
 
+void PicomimiGovernorClass::_printOpps() {
+  Serial.println(F("\n─── Operating Points ───"));
+  for (uint8_t i = 0; i < _opp_count; i++) {
+    Serial.print(i == _level ? F("> ") : F("  "));
+    Serial.print(i); Serial.print(F(": "));
+    Serial.print(_opps[i].pll.khz / 1000); Serial.print(F(" MHz  "));
+    Serial.print(_table[i].mv); Serial.print(F(" mV"));
+    if (_table[i].mv != _opps[i].nominal_mv) {
+      Serial.print(F(" (")); Serial.print(_opps[i].nominal_mv); Serial.print(F(")"));
+    }
+    Serial.print(F("  up "));
+    Serial.print(_table[i].up_pct); Serial.print(F("% down "));
+    Serial.print(_table[i].down_pct); Serial.print(F("%"));
+    for (uint8_t p = 0; p < PROFILE_COUNT; p++) {
+      if (_alias[p] == i) { Serial.print(F("  ")); Serial.print(PROFILE_NAMES[p]); }
+    }
+    Serial.println();
+  }
+  Serial.println();
+}
+
+void PicomimiGovernorClass::_printStats() {
+  uint64_t total_us = 0;
+  OppResidency r;
+  for (uint8_t i = 0; i < _opp_count; i++) {
+    if (getResidency(i, r)) total_us += r.time_us;
+  }
+  uint64_t total_uj = getEnergyUj();
+  
+  Serial.println(F("\n─── Residency ───"));
+  for (uint8_t i = 0; i < _opp_count; i++) {
+    if (!getResidency(i, r)) continue;
+    Serial.print(i == _level ? F("> ") : F("  "));
+    Serial.print(r.khz / 1000); Serial.print(F(" MHz  "));
+    Serial.print(total_us ? (float)r.time_us * 100.0f / (float)total_us : 0.0f, 1);
+    Serial.print(F("%  ")); Serial.print(r.entries); Serial.print(F("x  "));
+    Serial.print(r.current_ua / 1000.0f, 1); Serial.print(F(" mA  "));
+    Serial.print((uint32_t)(r.energy_uj / 1000)); Serial.println(F(" mJ"));
+  }
+  Serial.print(F("Total:    ")); Serial.print((uint32_t)(total_uj / 1000)); Serial.print(F(" mJ over "));
+  Serial.print((uint32_t)(total_us / 1000000)); Serial.print(F("s, avg "));
+  Serial.print(total_us ? (float)total_uj / (float)total_us * 1000.0f : 0.0f, 1);
+  Serial.println(F(" mW\n"));
+}
+
+void PicomimiGovernorClass::_printPhases() {
+  Serial.println(F("\n─── Phases ───"));
+  PhaseStats s;
+  for (uint8_t i = 0; i < PICOMIMI_MAX_PHASES; i++) {
+    if (!getPhaseStats(i, s)) continue;
+    Serial.print(F("  ")); Serial.print(i); Serial.print(F(": "));
+    Serial.print(s.count); Serial.print(F("x  last ")); Serial.print(s.last_us);
+    Serial.print(F("us  best ")); Serial.print(s.best_us);
+    Serial.print(F("us  avg ")); Serial.print((uint32_t)(s.total_us / s.count));
+    Serial.print(F("us  ")); Serial.print((uint32_t)(s.total_cycles / s.count / 1000));
+    Serial.print(F(" kcyc  -> ")); Serial.print(s.learned_khz / 1000); Serial.print(F(" MHz"));
+    Serial.println(s.settled ? F(" (settled)") : F(""));
+  }
+  Serial.println();
+}
+
 void PicomimiGovernorClass::_printStatus() {
   Serial.println(F("\n─── Governor Status ───"));
-  Serial.print(F("Profile:  ")); Serial.print(PROFILE_NAMES[_profile]);
-  Serial.print(F(" @ ")); Serial.print(_freq_khz / 1000); Serial.println(F(" MHz"));
-  Serial.print(F("Load:     ")); Serial.print(_avg_load, 1);
-  Serial.print(F("% (inst: ")); Serial.print(_instant_load, 1); Serial.println(F("%)"));
-  Serial.print(F("Temp:     ")); Serial.print(_temp, 1); Serial.println(F(" C"));
+  Serial.print(F("Profile:  ")); Serial.print(getProfileName());
+  Serial.print(F(" @ ")); Serial.print(_freq_khz / 1000); Serial.print(F(" MHz"));
+  if (_custom_count > 0) {
+    Serial.print(F(" (OPP ")); Serial.print(_level); Serial.print(F("/"));
+    Serial.print(_opp_count - 1); Serial.print(F(")"));
+  }
+  Serial.println();
+  Serial.print(F("Load:     ")); Serial.print(_avg_load / 65536.0f, 1);
+  Serial.print(F("% (inst: ")); Serial.print(_instant_load / 65536.0f, 1); Serial.println(F("%)"));
+  for (uint8_t i = 0; i < PICOMIMI_NUM_CORES; i++) {
+    if (!_cores[i].active) continue;
+    Serial.print(F("  Core")); Serial.print(i); Serial.print(F(":  "));
+    Serial.print(_cores[i].avg_load / 65536.0f, 1); Serial.println(F("%"));
+  }
+  Serial.print(F("Temp:     ")); Serial.print(_temp, 1); Serial.print(F(" C ("));
+  if (_temp_slope_mc >= 0) Serial.print('+');
+  Serial.print(_temp_slope_mc / 1000.0f, 2); Serial.print(F(" C/s"));
+  Serial.println(_temp_mode == TEMP_SAMPLE_DMA ? F(", DMA)") : F(")"));
   Serial.print(F("Chip:     ")); Serial.println(_chip == PICOMIMI_RP2350 ? "RP2350" : "RP2040");
+  Serial.print(F("Flash:    ")); Serial.print(getFlashClockMHz()); Serial.print(F(" MHz (div "));
+  Serial.print(_flash_div); Serial.print(F("), XIP hit ")); Serial.print(getXipHitRate(), 1);
+  Serial.println(_xip_bound ? F("%, capped") : F("%"));
+  if (_bus_min_eff) {
+    Serial.print(F("Bus:      ")); Serial.print(_bus_eff); Serial.print(F("% uncontested"));
+    Serial.println(_bus_eff < _bus_min_eff ? F(", holding") : F(""));
+  }
+  Serial.print(F("Policy:   "));
+  Serial.println(_ops->name);
+  for (uint8_t i = 0; i < PICOMIMI_NUM_CORES; i++) {
+    if (_cores[i].pred_period_us == 0) continue;
+    Serial.print(F("  Core")); Serial.print(i); Serial.print(F(" bursts every "));
+    Serial.print(_cores[i].pred_period_us); Serial.println(F("us"));
+  }
+  if (_deadline_us > 0) {
+    Serial.print(F("Deadline: ")); Serial.print(_task_us);
+    Serial.print(F("us / ")); Serial.print(_deadline_us);
+    Serial.print(F("us (")); Serial.print(_deadline_misses); Serial.println(F(" missed)"));
+  }
   Serial.print(F("Mode:     "));
   if (_override_on) {
     Serial.print(F("MANUAL"));
@@ -485,8 +3333,36 @@ void PicomimiGovernorClass::_printStatus() {
       Serial.print(F("s)"));
     }
   } else Serial.print(F("AUTO"));
+  if (_service_mode == SERVICE_TIMER) Serial.print(F(" (timer)"));
+  if (_service_mode == SERVICE_CORE1) Serial.print(F(" (core1)"));
   Serial.println();
+  Serial.print(F("Peri:     "));
+  Serial.print(clock_get_hz(clk_peri) / 1000000);
+  Serial.println(_peri_clock == PERI_CLOCK_FIXED_USB ? F(" MHz (fixed)") : F(" MHz (follows sys)"));
+  Serial.print(F("Stall:    ")); Serial.print(_stall_last_us);
+  Serial.print(F("us last, ")); Serial.print(_stall_max_us);
+  Serial.print(F("us max (")); Serial.print(_transitions); Serial.println(F(" changes)"));
+  if (_idle_mode == IDLE_SLEEP) {
+    Serial.print(F("Idle:     SLEEP (wake ")); Serial.print(_wake_lat_us);
+    Serial.print(F("us avg, ")); Serial.print(_wake_lat_max_us); Serial.println(F("us max)"));
+  } else if (_idle_mode == IDLE_DEEP) {
+    Serial.print(F("Idle:     DEEP (")); Serial.print(_deep_count);
+    Serial.print(F(" times, ")); Serial.print(_deep_entry_us);
+    Serial.print(F("us in, ")); Serial.print(_deep_exit_us);
+    Serial.print(F("us out, from ")); Serial.print(getDeepBreakEvenUs()); Serial.println(F("us)"));
+  }
+  if (_qos_floor_khz || _qos_ceil_khz) {
+    Serial.print(F("QoS:      floor "));
+    if (_qos_floor_khz) { Serial.print(_qos_floor_khz / 1000); Serial.print(F(" MHz")); }
+    else Serial.print('-');
+    Serial.print(F(", ceiling "));
+    if (_qos_ceil_khz) { Serial.print(_qos_ceil_khz / 1000); Serial.println(F(" MHz")); }
+    else Serial.println('-');
+  }
   if (_turbo_on) Serial.println(F("          TURBO ACTIVE"));
-  if (_throttled) Serial.println(F("          THERMAL THROTTLED"));
+  if (_throttled) {
+    Serial.print(F("          THERMAL CAP ")); Serial.print(getFreqCapMHz());
+    Serial.print(F(" MHz (target ")); Serial.print(_pid.target_c, 1); Serial.println(F("°C)"));
+  }
   Serial.println();
 }
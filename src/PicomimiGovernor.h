@@ -25,6 +25,7 @@
  *   - Measures time spent in user code vs idle time
  *   - Fast loops with no idle() = high load = boost frequency
  *   - Loops with idle() calls = low load = save power
+ *   - Call run() from loop1() too and core1's work counts as well
  *
  * MANUAL MODE:
  *   PicomimiGov.begin(PICOMIMI_RP2350, true);  // true = enable serial commands
@@ -36,10 +37,12 @@
 
 #include <Arduino.h>
 #include <hardware/clocks.h>
+#include <hardware/pll.h>
 #include <hardware/vreg.h>
 #include <hardware/adc.h>
 #include <hardware/sync.h>
 #include <pico/time.h>
+#include "PicomimiPolicy.h"
 
 // ============================================================================
 // CHIP SELECTION
@@ -63,6 +66,373 @@ enum PowerProfile : uint8_t {
   PROFILE_COUNT     = 5
 };
 
+// ============================================================================
+// PLL SETTINGS
+// ============================================================================
+
+// One entry per table frequency, worked out at compile time
+struct PllConfig {
+  uint32_t khz;
+  uint32_t vco_khz;    // 0 = not reachable from the 12 MHz crystal
+  uint8_t postdiv1;
+  uint8_t postdiv2;
+};
+
+// ============================================================================
+// OPERATING POINTS
+// ============================================================================
+
+#define PICOMIMI_MAX_OPPS 24
+
+// A user-supplied (frequency, voltage) pair, lowest frequency first
+struct OperatingPoint {
+  uint32_t khz;
+  uint32_t mv;
+};
+
+// ============================================================================
+// PERIPHERAL CLOCKS
+// ============================================================================
+
+enum PeriClock : uint8_t {
+  PERI_CLOCK_FOLLOW_SYS = 0,   // clk_peri = clk_sys, moves with every change (default)
+  PERI_CLOCK_FIXED_USB  = 1    // clk_peri stays on pll_usb at 48 MHz
+};
+
+#define PICOMIMI_MAX_CLOCK_HOOKS 4
+
+// Runs with interrupts off on the core doing the change, right after the
+// new clk_sys is live. Use it to re-derive PWM/PIO/I2C dividers.
+typedef void (*ClockChangeHook)(uint32_t old_khz, uint32_t new_khz, void* ctx);
+
+// ============================================================================
+// DUAL-CORE LOAD
+// ============================================================================
+
+#define PICOMIMI_NUM_CORES 2
+
+// Idle sampling: a raw timer alarm per core notes whether it interrupted
+// a WFE/WFI (delay(), sleep_ms(), a library waiting). 0 = off, load then
+// comes from idle() and run() polling only.
+#ifndef PICOMIMI_IDLE_SAMPLE_HZ
+#define PICOMIMI_IDLE_SAMPLE_HZ 1000
+#endif
+
+// run() calls closer together than this are a loop with nothing to do
+#ifndef PICOMIMI_SPIN_GAP_US
+#define PICOMIMI_SPIN_GAP_US 20
+#endif
+
+enum LoadMix : uint8_t {
+  LOAD_MIX_MAX      = 0,   // Busiest core decides (default)
+  LOAD_MIX_WEIGHTED = 1    // Weighted mix of active cores
+};
+
+// ============================================================================
+// SCALING POLICY
+// ============================================================================
+
+enum ScalingPolicy : uint8_t {
+  POLICY_LADDER       = 0,   // Threshold ladder on smoothed load (default)
+  POLICY_PREDICTIVE   = 1,   // Utilisation-based target + raise ahead of periodic bursts
+  POLICY_INTERACTIVE  = 2,   // Jump to the top on a busy window, hold, then step down to fit
+  POLICY_CONSERVATIVE = 3,   // One level per decision towards the schedutil target
+  POLICY_ONDEMAND     = 4,   // Top on a busy window, otherwise linear in load
+  POLICY_SCHEDUTIL    = 5,   // Headroom over the frequency the load needs
+  POLICY_POWERSAVE    = 6,   // Lowest allowed level
+  POLICY_PERFORMANCE  = 7,   // Highest allowed level
+  POLICY_CUSTOM       = 8    // Set through setPolicy(const PolicyOps&)
+};
+
+#define PICOMIMI_BURST_HISTORY 8
+#define PICOMIMI_TASK_HISTORY  16
+
+// ============================================================================
+// SERVICE MODE
+// ============================================================================
+
+enum GovernorService : uint8_t {
+  SERVICE_LOOP  = 0,  // run() from loop() drives everything (default)
+  SERVICE_TIMER = 1,  // Timer interrupt scales; run() only needed for serial
+  SERVICE_CORE1 = 2   // Core1 runs the governor; the sketch can't use setup1()/loop1()
+};
+
+// ============================================================================
+// TEMPERATURE SAMPLING
+// ============================================================================
+
+enum TempSampling : uint8_t {
+  TEMP_SAMPLE_SINGLE = 0,   // Median of a short blocking burst per decision (default)
+  TEMP_SAMPLE_DMA    = 1    // Free-running round robin into a DMA ring, shared with the app
+};
+
+#define PICOMIMI_ADC_RING      64   // Samples; 128 bytes so the DMA ring can wrap on it
+#define PICOMIMI_TEMP_SAMPLES  15   // Temperature readings in each median
+
+// ============================================================================
+// IDLE BACKEND
+// ============================================================================
+
+enum IdleMode : uint8_t {
+  IDLE_SPIN  = 0,   // delay() / delayMicroseconds() (default)
+  IDLE_SLEEP = 1,   // Hardware alarm + WFE, core sleeps until it fires
+  IDLE_DEEP  = 2    // IDLE_SLEEP, plus crystal clock and pll_sys off for long windows
+};
+
+enum IdleSource : uint8_t {
+  IDLE_SOURCE_DECLARED = 0,   // idle() and run() polling only: delay() is work
+  IDLE_SOURCE_SAMPLED  = 1    // WFE/WFI sampled in hardware as well
+};
+
+// ============================================================================
+// DECISION TRACE
+// ============================================================================
+
+// Ring of the last N level changes; a power of two so wrap is a mask
+#ifndef PICOMIMI_TRACE_SIZE
+#define PICOMIMI_TRACE_SIZE 64
+#endif
+
+enum TraceReason : uint8_t {
+  TRACE_START    = 0,   // begin()
+  TRACE_LOAD     = 1,   // Ladder threshold crossed
+  TRACE_BOOST    = 2,   // inputBoost()
+  TRACE_THERMAL  = 3,   // Throttle engaged/released
+  TRACE_OVERRIDE = 4,   // setProfile()/setOpp()/serial/calibrate()
+  TRACE_TIMEOUT  = 5,   // Turbo time limit
+  TRACE_DEADLINE = 6,   // Deadline controller
+  TRACE_PREDICT  = 7,   // Predictive policy
+  TRACE_IDLE     = 8,   // idle() downclock and return
+  TRACE_QOS      = 9,   // A QoS floor or ceiling moved
+  TRACE_PHASE    = 10   // hint()/hintEnd()
+};
+
+// 16 bytes, little-endian on the wire exactly as in memory
+struct TraceRecord {
+  uint32_t time_ms;
+  int16_t temp_dc;         // 0.1 °C
+  uint16_t stall_us;       // Transition stall, saturated
+  uint16_t mhz;            // New frequency
+  uint8_t instant_load;    // %
+  uint8_t avg_load;        // %
+  uint8_t from_level;
+  uint8_t to_level;
+  uint8_t reason;          // TraceReason
+  uint8_t flags;           // Bit 0 throttled, bit 1 override, bit 2 boost
+};
+
+// ============================================================================
+// TELEMETRY
+// ============================================================================
+
+// 28 bytes, little-endian on the wire exactly as in memory. Counters are
+// totals that wrap; take differences between frames.
+struct TelemetryRecord {
+  uint32_t time_ms;
+  uint32_t transitions;
+  uint16_t seq;            // Per frame, gaps mean lost frames
+  uint16_t mhz;
+  uint16_t cap_mhz;        // Thermal cap
+  int16_t temp_dc;         // 0.1 °C
+  uint16_t throttles;      // Times the thermal cap came on
+  uint16_t stall_max_us;   // Worst transition stall, saturated
+  uint16_t deadline_misses;
+  uint8_t core_load[2];    // %, smoothed
+  uint8_t avg_load;        // %
+  uint8_t level;
+  uint8_t flags;           // Bit 0 throttled, bit 1 override, bit 2 boost, bit 3 turbo
+  uint8_t reserved;
+};
+
+// Header + record + residency per point + CRC
+#define PICOMIMI_TELEMETRY_MAX_FRAME (8 + sizeof(TelemetryRecord) + 2 * PICOMIMI_MAX_OPPS + 4)
+
+typedef void (*TelemetryCallback)(const uint8_t* frame, size_t len, void* ctx);
+
+// ============================================================================
+// RESIDENCY
+// ============================================================================
+
+struct OppResidency {
+  uint32_t khz;
+  uint64_t time_us;        // Time spent at this point
+  uint32_t entries;        // Transitions into it
+  uint32_t current_ua;     // Model (or measured) current
+  uint64_t energy_uj;      // Estimated, from current x supply voltage x time
+};
+
+// ============================================================================
+// CONFIGURATION
+// ============================================================================
+
+/**
+ * Build-time tunables. Derive, override what differs and instantiate
+ * PicomimiGovernor<YourConfig>; bad combinations fail to compile.
+ *
+ *   struct FastConfig : GovernorConfig {
+ *     static constexpr uint8_t turbo_up = 60;
+ *     static constexpr uint32_t turbo_max_ms = 3000;
+ *   };
+ *   PicomimiGovernor<FastConfig> Gov;
+ */
+struct GovernorConfig {
+  // Ladder thresholds, load % to move into (up) and out of (down) a level
+  static constexpr uint8_t turbo_up = PICOMIMI_TURBO_UP;
+  static constexpr uint8_t turbo_down = PICOMIMI_TURBO_DOWN;
+  static constexpr uint8_t perf_up = PICOMIMI_PERF_UP;
+  static constexpr uint8_t perf_down = PICOMIMI_PERF_DOWN;
+  static constexpr uint8_t bal_up = PICOMIMI_BAL_UP;
+  static constexpr uint8_t bal_down = PICOMIMI_BAL_DOWN;
+  static constexpr uint8_t save_down = PICOMIMI_SAVE_DOWN;
+  static constexpr uint8_t ultra_down = 2;          // RP2350 WFIs in run() at level 0 below this
+  
+  static constexpr uint8_t load_smooth_pct = PICOMIMI_LOAD_SMOOTH_PCT;
+  static constexpr uint8_t sched_headroom_pct = PICOMIMI_SCHED_HEADROOM_PCT;
+  static constexpr uint8_t hispeed_load = PICOMIMI_HISPEED_PCT;
+  static constexpr uint8_t target_load = PICOMIMI_TARGET_PCT;
+  static constexpr uint32_t hispeed_hold_ms = PICOMIMI_HISPEED_HOLD_MS;
+  
+  // Timing
+  static constexpr uint32_t load_period_ms = PICOMIMI_LOAD_PERIOD_MS;
+  static constexpr uint32_t scale_interval_ms = PICOMIMI_SCALE_INTERVAL_MS;
+  static constexpr uint32_t turbo_max_ms = 10000;   // TURBO falls back after this long
+  static constexpr uint32_t boost_ms = 300;         // inputBoost() hold
+};
+
+// The same values at runtime: what setTunables()/getTunables() and the
+// set/get serial commands work on
+struct GovernorTunables {
+  uint8_t turbo_up;
+  uint8_t turbo_down;
+  uint8_t perf_up;
+  uint8_t perf_down;
+  uint8_t bal_up;
+  uint8_t bal_down;
+  uint8_t save_down;
+  uint8_t ultra_down;
+  uint8_t load_smooth_pct;
+  uint8_t sched_headroom_pct;
+  uint8_t hispeed_load;
+  uint8_t target_load;
+  uint32_t hispeed_hold_ms;
+  uint32_t load_period_ms;
+  uint32_t scale_interval_ms;
+  uint32_t turbo_max_ms;
+  uint32_t boost_ms;
+};
+
+template <class C>
+constexpr GovernorTunables governorTunables() {
+  static_assert(C::save_down < C::bal_down && C::bal_down < C::perf_down && C::perf_down < C::turbo_down,
+                "down thresholds must rise with the level");
+  static_assert(C::bal_up < C::perf_up && C::perf_up < C::turbo_up && C::turbo_up <= 100,
+                "up thresholds must rise with the level, up to 100%");
+  static_assert(C::bal_down < C::bal_up && C::perf_down < C::perf_up && C::turbo_down < C::turbo_up,
+                "each level's down threshold must sit below its up threshold");
+  static_assert(C::ultra_down <= C::save_down, "ultra_down can't exceed save_down");
+  static_assert(C::load_smooth_pct >= 1 && C::load_smooth_pct <= 100, "load_smooth_pct is 1..100");
+  static_assert(C::sched_headroom_pct >= 100, "sched_headroom_pct below 100 never reaches the load");
+  static_assert(C::hispeed_load <= 100, "hispeed_load is a load %");
+  static_assert(C::target_load >= 1 && C::target_load <= 100, "target_load is 1..100");
+  static_assert(C::scale_interval_ms > 0 && C::load_period_ms >= C::scale_interval_ms,
+                "a load window spans at least one decision");
+  return GovernorTunables{
+    C::turbo_up, C::turbo_down, C::perf_up, C::perf_down, C::bal_up, C::bal_down,
+    C::save_down, C::ultra_down, C::load_smooth_pct, C::sched_headroom_pct,
+    C::hispeed_load, C::target_load, C::hispeed_hold_ms, C::load_period_ms, C::scale_interval_ms, C::turbo_max_ms, C::boost_ms
+  };
+}
+
+// ============================================================================
+// CROSS-CORE CONTROL
+// ============================================================================
+
+// A consistent copy of the governor's state, published by the scaling
+// context after every decision and level change
+struct GovernorStatus {
+  uint32_t freq_khz;
+  uint32_t cap_khz;              // Thermal cap
+  load_q16_t avg_load;
+  load_q16_t instant_load;
+  load_q16_t core_load[PICOMIMI_NUM_CORES];
+  int32_t temp_mc;
+  uint8_t level;
+  uint8_t profile;
+  bool turbo;
+  bool throttled;
+  bool boost;
+  bool override_on;
+};
+
+// Commands queued per calling core until the scaling context takes them
+#ifndef PICOMIMI_MAILBOX_SIZE
+#define PICOMIMI_MAILBOX_SIZE 8
+#endif
+
+// ============================================================================
+// QOS REQUESTS
+// ============================================================================
+
+#ifndef PICOMIMI_MAX_QOS
+#define PICOMIMI_MAX_QOS 8
+#endif
+
+// ============================================================================
+// FLASH (XIP)
+// ============================================================================
+
+#ifndef PICOMIMI_XIP_HIT_PCT
+#define PICOMIMI_XIP_HIT_PCT 90      // setXipLimit() default: below this hit rate code is flash-bound
+#endif
+
+// ============================================================================
+// BUS CONTENTION
+// ============================================================================
+
+#ifndef PICOMIMI_BUS_EFF_PCT
+#define PICOMIMI_BUS_EFF_PCT 70      // Below this share of uncontested accesses, don't ramp
+#endif
+
+// ============================================================================
+// PHASE HINTS
+// ============================================================================
+
+// Where a phase starts before it has learned anything
+enum WorkloadPhase : uint8_t {
+  PHASE_IDLE    = 0,   // Waiting for input or a timer: bottom level
+  PHASE_UI      = 1,   // Drawing, handling input: PERFORMANCE
+  PHASE_IO      = 2,   // Bus or flash bound: BALANCED
+  PHASE_COMPUTE = 3,   // CPU bound: top level
+  PHASE_USER    = 4    // First id free for the application, starts at the top
+};
+
+#ifndef PICOMIMI_MAX_PHASES
+#define PICOMIMI_MAX_PHASES 8
+#endif
+#define PICOMIMI_PHASE_DEPTH     4    // Nested hints
+#define PICOMIMI_PHASE_SLACK_PCT 10   // Slowdown a lower level may cost
+
+struct PhaseStats {
+  uint32_t count;
+  uint32_t last_us;
+  uint32_t best_us;        // Reference runtime the learning compares against
+  uint64_t total_us;
+  uint64_t total_cycles;   // Runtime x the clock at the end of each run
+  uint32_t learned_khz;    // Where the next hint pins, 0 = never run
+  bool settled;            // Stopped trying lower levels
+};
+
+// ============================================================================
+// SERIAL COMMANDS
+// ============================================================================
+
+// Longest command line, including the terminator; longer lines are dropped
+#ifndef PICOMIMI_CMD_MAX
+#define PICOMIMI_CMD_MAX 48
+#endif
+
+struct SerialCommand;
+
 // ============================================================================
 // GOVERNOR CLASS
 // ============================================================================
@@ -70,53 +440,484 @@ enum PowerProfile : uint8_t {
 class PicomimiGovernorClass {
 public:
   PicomimiGovernorClass();
+  explicit PicomimiGovernorClass(const GovernorTunables& tunables);
   
   // ===== CORE API =====
-  void begin(PicomimiChip chip, bool manual = false);
+  /**
+   * SERVICE_TIMER samples load from a timer interrupt every 100 ms and
+   * decides in a lowest-priority spare interrupt, so thermal checks keep
+   * running while loop() is blocked. SERVICE_CORE1 launches the
+   * governor on core1, which sleeps in WFE between decisions; core0's
+   * run() only feeds its counters. Load is measured the same way in
+   * every mode, for core0 alone in SERVICE_CORE1. Deadline timing
+   * without beginTask()/endTask() follows core0's loop() there.
+   */
+  void begin(PicomimiChip chip, bool manual = false, GovernorService service = SERVICE_LOOP);
   void run();
   void inputBoost();
   
+  /**
+   * SERVICE_CORE1 only, no-ops otherwise: arduino-pico doesn't know core1
+   * is running, so EEPROM.commit() and LittleFS can't park it and it
+   * would keep executing from flash mid-erase. Bracket those writes with
+   * these to park core1 in RAM. Nests.
+   */
+  void beginFlashWrite();
+  void endFlashWrite();
+  
   /**
    * Call this instead of delay() - counts as idle time
    * Optional but improves accuracy for very short delays
+   * Safe to call from either core; each core has its own counters.
    */
   void idle(uint32_t ms);
   void idleMicros(uint32_t us);
   
+  // ===== TUNABLES =====
+  /**
+   * Change the config live. Rejected (false) if it breaks the same rules
+   * GovernorConfig is checked against at compile time. saveTunables()
+   * stores the current set in flash; begin() loads it over the
+   * compiled-in defaults until clearTunables(). From another core or an
+   * interrupt the set is queued and lands at the next decision.
+   */
+  bool setTunables(const GovernorTunables& t);
+  GovernorTunables getTunables();
+  bool saveTunables();
+  void clearTunables();
+  
   // ===== STATUS =====
   uint32_t getFreqMHz();
   float getCPULoad();
+  float getCPULoad(uint8_t core);
   float getTemperature();
   PowerProfile getProfile();
   const char* getProfileName();
   bool isTurbo();
-  bool isThrottled();
+  bool isThrottled();            // Thermal cap below the top level
+  uint32_t getFreqCapMHz();      // Highest frequency the thermal loop allows
+  
+  /**
+   * Status reads come from a snapshot, never the live state, so any core
+   * or ISR can call them and none of them waits on a frequency change.
+   * Control calls (setProfile(), inputBoost(), QoS...) made from the
+   * other core or an ISR are queued and carried out by the scaling
+   * context on its next pass; from the core that called begin() they
+   * act immediately.
+   */
+  void getStatus(GovernorStatus& out);
+  uint32_t getDroppedCommands();  // Queued calls lost to a full mailbox
+  
+  // ===== OPERATING POINTS =====
+  /**
+   * Replace the built-in five-entry table with up to PICOMIMI_MAX_OPPS
+   * points, sorted by frequency. Call before begin(); begin() drops any
+   * entry the PLL can't make from the 12 MHz crystal. Profiles then
+   * alias the point nearest each built-in profile frequency.
+   */
+  bool setOperatingPoints(const OperatingPoint* opps, uint8_t count);
+  uint8_t getOppCount();
+  uint8_t getOpp();                         // Current level, 0 = slowest
+  uint32_t getOppFreqMHz(uint8_t level);
+  
+  // ===== UNDERVOLT CALIBRATION =====
+  /**
+   * Opt-in, blocking, a few seconds per level; call from setup() before
+   * core1 starts work. At every level it steps the regulator down from
+   * the table voltage while a CRC/matrix kernel checks its own results,
+   * keeps the lowest voltage that never miscomputed, adds guard_steps x
+   * 50 mV and saves the curve to flash. begin() loads it from then on.
+   * A watchdog catches hangs: calling calibrate() again after the reset
+   * picks up where it stopped, counting the voltage that hung as failed.
+   * In SERVICE_CORE1 it has to run on core1, i.e. from the 'cal' command.
+   */
+  bool calibrate(uint8_t guard_steps = 1);
+  bool hasCalibration();
+  void clearCalibration();
+  uint32_t getOppVoltage(uint8_t level);    // mV in use at that level
   
   // ===== MANUAL CONTROL =====
+  void setOpp(uint8_t level, uint32_t duration_sec = 0);
   void setProfile(PowerProfile p, uint32_t duration_sec = 0);
   void setTurbo(uint32_t duration_sec = 30);
   void setPowersave(uint32_t duration_sec = 60);
   void setAuto();
   
+  // ===== QOS REQUESTS =====
+  /**
+   * Independent clients each hold a floor (or ceiling) on the clock for
+   * as long as they need it. The governor runs at the highest floor and
+   * under the lowest ceiling, whatever the load says; ceilings beat
+   * floors and the thermal cap beats both. timeout_ms = 0 holds until
+   * removed. Returns a handle, or -1 when all PICOMIMI_MAX_QOS are taken.
+   *
+   *   int audio = PicomimiGov.addMinFreqRequest(150);
+   *   ...
+   *   PicomimiGov.removeRequest(audio);
+   */
+  int addMinFreqRequest(uint32_t mhz, uint32_t timeout_ms = 0);
+  int addMaxFreqRequest(uint32_t mhz, uint32_t timeout_ms = 0);
+  bool updateRequest(int handle, uint32_t mhz, uint32_t timeout_ms = 0);
+  void removeRequest(int handle);
+  uint32_t getMinFreqMHz();   // Highest active floor, 0 if none
+  uint32_t getMaxFreqMHz();   // Lowest active ceiling, 0 if none
+  
+  // ===== PHASE HINTS =====
+  /**
+   * Say a known phase is starting. The clock moves to the phase's level
+   * at once and stays pinned there (QoS and thermal limits still apply)
+   * until hintEnd(), which goes back to the level from before. Each run
+   * is timed; the next one tries a level lower and keeps it while the
+   * runtime stays within PICOMIMI_PHASE_SLACK_PCT of the best, or within
+   * the budget if one is set. CPU-bound phases settle high, bus-bound
+   * ones low. Returns a token for hintEnd(), or -1 before begin(), for
+   * an id past PICOMIMI_MAX_PHASES or nesting past PICOMIMI_PHASE_DEPTH.
+   * GovernorScope does the pairing.
+   */
+  int hint(uint8_t phase);
+  void hintEnd(int token);                            // Ends phases nested inside it too
+  void setPhaseBudget(uint8_t phase, uint32_t us);    // 0 = compare with the best run
+  bool getPhaseStats(uint8_t phase, PhaseStats& out);
+  void resetPhases();
+  
+  /**
+   * How per-core loads combine into the scaling decision.
+   * core1_weight is 0-100 and only used by LOAD_MIX_WEIGHTED.
+   */
+  void setLoadMix(LoadMix mix, uint8_t core1_weight = 50);
+  
+  /**
+   * POLICY_PREDICTIVE remembers the last few long iterations on each
+   * core. When they repeat at a steady period (a 50 Hz display refresh,
+   * say) the clock is raised just before the next one is due.
+   *
+   * POLICY_INTERACTIVE goes straight to the top when one window's busy
+   * time reaches hispeed_load, stays there at least hispeed_hold_ms,
+   * then steps to the level that puts the load at target_load.
+   *
+   * The rest are plain PolicyOps: a function from a LoadSample to a
+   * level, with QoS and thermal limits applied after it. An application
+   * can pass its own; ops must stay valid while selected. Off the
+   * scaling context the switch is queued and lands between decisions.
+   */
+  void setPolicy(ScalingPolicy policy);
+  void setPolicy(const PolicyOps& ops);
+  ScalingPolicy getPolicy();
+  const char* getPolicyName();
+  uint32_t getBurstPeriodUs(uint8_t core = 0);   // 0 = no steady burst found
+  
+  // ===== THERMAL =====
+  /**
+   * A PID loop holds the die at target_c by capping the frequency, so a
+   * hot enclosure runs at the fastest level it can sustain instead of
+   * bouncing between two. Gains are kHz per °C, per °C·s and per °C/s.
+   * Above 80 °C the cap drops to POWERSAVE regardless.
+   */
+  void setThermalTarget(float target_c);
+  float getThermalTarget();
+  void setThermalGains(float kp, float ki, float kd);
+  
+  /**
+   * TEMP_SAMPLE_DMA runs the ADC free in round robin over the app's
+   * inputs (bits 0-3 of app_inputs) plus the sensor, rate_hz per input,
+   * with DMA into a ring. Nothing blocks and the mux is never switched;
+   * read the app's inputs with getAdcSample() instead of adc_read().
+   * Needs a free DMA channel; returns false if none.
+   */
+  bool setTempSampling(TempSampling mode, uint8_t app_inputs = 0, uint32_t rate_hz = 1000);
+  TempSampling getTempSampling();
+  uint16_t getAdcSample(uint8_t input);   // Latest raw reading, DMA mode
+  float getTemperatureSlope();            // °C/s, from the filtered temperature
+  
+  // ===== DEADLINE =====
+  /**
+   * Pick the slowest profile whose predicted iteration time still fits
+   * the deadline minus margin_pct. Iterations are timed run() to run()
+   * (minus idle()), or between beginTask()/endTask() once those are
+   * used. Overrides the load policy while set; 0 turns it off.
+   */
+  void setDeadline(uint32_t us, uint8_t margin_pct = 10);
+  void beginTask();
+  void endTask();
+  uint32_t getTaskTimeUs();       // Last measured iteration
+  uint32_t getDeadlineMisses();
+  
+  // ===== IDLE BACKEND =====
+  /**
+   * IDLE_SLEEP arms an alarm and sleeps in WFE instead of spinning.
+   * Windows shorter than min_sleep_us (plus the measured wake latency)
+   * still spin. downclock_ms > 0 drops to the lowest clock the QoS
+   * floor allows for idle windows at least that long, restoring it on
+   * wake; not while a manual override or a phase hint is in force.
+   */
+  void setIdleMode(IdleMode mode, uint32_t min_sleep_us = 20, uint32_t downclock_ms = 0);
+  uint32_t getWakeLatencyUs();
+  uint32_t getMaxWakeLatencyUs();
+  
+  /**
+   * Where a core's idle comes from. DECLARED means no idle sampler: no
+   * free hardware alarm, PICOMIMI_IDLE_SAMPLE_HZ set to 0, or a RISC-V
+   * build. delay() then reads as work, so wait with PicomimiGov.idle().
+   */
+  IdleSource getIdleSource(uint8_t core = 0);
+  
+  /**
+   * IDLE_DEEP moves clk_sys to the crystal, stops pll_sys and drops the
+   * core voltage to the table's lowest for windows long enough to repay
+   * it, then relocks and restores the level before the window ends.
+   * Only while core1 isn't calling run(). The break-even window comes
+   * from the measured entry/exit times and the current model.
+   *
+   * sleepUntilPin() goes dormant: every oscillator stops until gpio sees
+   * the edge. USB drops, and the system timer stops too, so the dormant
+   * stretch counts as neither idle nor work. Returns false, without
+   * sleeping, if core1 is active.
+   */
+  uint32_t getDeepEntryUs();
+  uint32_t getDeepExitUs();
+  uint32_t getDeepBreakEvenUs();   // At the current level
+  uint32_t getDeepIdleCount();
+  bool sleepUntilPin(uint8_t gpio, bool rising = true);
+  
+  // ===== TRANSITIONS =====
+  uint32_t getTransitionStallUs();      // Last frequency change
+  uint32_t getMaxTransitionStallUs();
+  uint32_t getTransitionCount();
+  
+  // ===== RESIDENCY & ENERGY =====
+  /**
+   * Time, entries and estimated energy per operating point. Current comes
+   * from a per-chip f x V model of a busy core on a 3.3 V supply. Feed it
+   * a real reading (INA219 or a meter) with setMeasuredCurrent() while
+   * pinned at a point: that point uses the reading, the others are
+   * rescaled by the same factor.
+   */
+  bool getResidency(uint8_t level, OppResidency& out);
+  uint64_t getEnergyUj();
+  void setMeasuredCurrent(float ma);
+  void resetStats();
+  
+  // ===== TRACE =====
+  /**
+   * Every level change (and throttle change) lands in a fixed ring of
+   * TraceRecords. dumpTrace() writes it oldest first as one binary frame:
+   * "PGTR", version, record size, count (u16), records, CRC-32 (u32).
+   * extras/trace_decode.py turns that into CSV or a plot.
+   */
+  uint16_t getTraceCount();
+  bool getTrace(uint16_t i, TraceRecord& out);   // 0 = oldest
+  void clearTrace();
+  void dumpTrace(Print& out);
+  
+  // ===== TELEMETRY =====
+  /**
+   * One binary frame every period_ms (rounded up to the scale interval),
+   * written from the scaling context: "PGTM", version, record size, OPP
+   * count, reserved, a TelemetryRecord, residency since the last frame
+   * per point (u16, per mille), CRC-32 (u32). Built in a fixed buffer;
+   * the sink's own write time is on top. extras/telemetry_decode.py
+   * prints a stream of them as CSV.
+   *
+   * A Print is only written from thread context, by run() (or core1 in
+   * SERVICE_CORE1), so SERVICE_TIMER still needs run() for it. A
+   * callback is called where the decision ran: in SERVICE_TIMER that is
+   * the decide interrupt, so it must not block.
+   */
+  void setTelemetry(Print& out, uint32_t period_ms = 1000);
+  void setTelemetry(TelemetryCallback cb, void* ctx = nullptr, uint32_t period_ms = 1000);
+  void stopTelemetry();
+  
+  // ===== PERIPHERAL CLOCKS =====
+  /**
+   * PERI_CLOCK_FIXED_USB keeps UART/SPI baud rates put whatever clk_sys
+   * does (SPI tops out at 24 MHz then). It also pins clk_adc and clk_usb
+   * to pll_usb. Call it before starting UART/SPI so they see 48 MHz.
+   * PWM, PIO and RP2040 I2C run from clk_sys and still need a hook.
+   */
+  void setPeriClock(PeriClock mode);
+  bool addClockHook(ClockChangeHook hook, void* ctx = nullptr);
+  void removeClockHook(ClockChangeHook hook);
+  
+  // ===== FLASH (XIP) =====
+  /**
+   * Code running from flash stops getting faster once cache misses wait
+   * on the QSPI clock. With a flash limit set, the QSPI divider is
+   * retuned with every frequency change so SCK stays at the fastest rate
+   * not above max_mhz; 0 (the default) leaves boot2's divider alone.
+   * Takes effect from begin() or the next frequency change. The divider
+   * only changes from thread context: in SERVICE_TIMER, where levels
+   * change in an interrupt, it stays at what the top level needs.
+   *
+   * The XIP cache counters are read every load window. Once
+   * setXipLimit() is called, while fewer than hit_pct of accesses hit,
+   * the clock is capped at the lowest level that already gets within
+   * 10% of the best flash clock. QoS floors still win over the cap.
+   * Off (hit_pct = 0) by default.
+   */
+  void setFlashClock(uint32_t max_mhz);
+  uint32_t getFlashClockMHz();                  // Current SCK
+  void setXipLimit(uint8_t hit_pct = PICOMIMI_XIP_HIT_PCT);
+  float getXipHitRate();                        // %, last load window
+  bool isXipBound();
+  
+  // ===== BUS CONTENTION =====
+  /**
+   * Claims the four bus performance counters (nothing else may use them
+   * meanwhile) to count XIP and SRAM accesses, and how many had to wait
+   * for another master, every load window. The uncontested share is the
+   * efficiency; while it is below min_eff_pct the scaler doesn't ramp
+   * up, since a core waiting on DMA traffic only waits faster. Policies
+   * see it as LoadSample::efficiency_pct. 0 releases the counters.
+   */
+  void setBusClassifier(uint8_t min_eff_pct = PICOMIMI_BUS_EFF_PCT);
+  uint8_t getBusEfficiency();   // %, 100 while off or idle
+  
 private:
+  // Per-core accounting. Each slot is written only by its own core;
+  // idle_total_us is a free-running 32-bit counter so the scaling core
+  // can read it without locks and work out deltas (wrap-safe).
+  struct CoreLoad {
+    volatile uint32_t idle_us;   // Declared idle since the last run()
+    volatile bool active;
+    // Load source: timer-measured idle (time asleep in WFE/WFI with
+    // interrupts masked, or spun in idle()), and when the current idle
+    // stretch started (0 = not idling)
+    volatile uint32_t idle_total_us;
+    volatile uint32_t idle_since_us;
+    volatile bool waking;        // Out of a masked sleep, handlers not run yet
+    bool first_run;
+    uint32_t last_run_us;
+    uint32_t last_entry_us;      // When the last run() started
+    // Burst ring for POLICY_PREDICTIVE, also written by the owning core
+    uint32_t burst_start_us[PICOMIMI_BURST_HISTORY];
+    uint16_t burst_work_us[PICOMIMI_BURST_HISTORY];
+    uint16_t burst_mhz[PICOMIMI_BURST_HISTORY];
+    volatile uint8_t burst_head;
+    volatile uint8_t burst_count;
+    uint32_t typical_work_us;
+    // Owned by the scaling core
+    uint32_t seen_run_us;
+    uint32_t seen_idle_us;
+    uint32_t seen_ongoing_us;
+    uint32_t seen_samples;
+    uint32_t seen_idle_samples;
+    load_q16_t avg_load;
+    load_q16_t instant_load;
+    uint32_t pred_period_us;
+    uint8_t pred_level;
+  };
+  
+  // One table row: how to make the frequency. Thresholds and the voltage
+  // in use live in the matching _table entry, which the policy reads.
+  struct Opp {
+    PllConfig pll;
+    uint16_t nominal_mv;         // Table value, before calibration
+  };
+
+  GovernorTunables _cfg;
   bool _init;
   bool _manual;
   PicomimiChip _chip;
-  PowerProfile _profile;
+  uint8_t _level;
   uint32_t _freq_khz;
   float _temp;
   
   // Loop timing based CPU tracking
-  uint64_t _last_run_us;
-  uint64_t _run_start_us;
-  uint64_t _total_loop_time_us;
-  uint64_t _total_idle_time_us;
+  CoreLoad _cores[PICOMIMI_NUM_CORES];
+  uint8_t _owner_core;
   uint64_t _period_start_us;
-  float _avg_load;
-  float _instant_load;
+  load_q16_t _avg_load;
+  load_q16_t _instant_load;
+  LoadMix _load_mix;
+  uint8_t _core1_weight;
+  
+  // Idle backend
+  IdleMode _idle_mode;
+  uint32_t _min_sleep_us;
+  uint32_t _downclock_ms;
+  volatile uint32_t _wake_lat_us;
+  volatile uint32_t _wake_lat_max_us;
+  uint32_t _deep_entry_us;
+  uint32_t _deep_exit_us;
+  uint32_t _deep_count;
+  
+  // Transition stats
+  uint32_t _stall_last_us;
+  uint32_t _stall_max_us;
+  uint32_t _vreg_settle_us;
+  uint32_t _transitions;
   
-  // Scaling
-  uint64_t _last_scale_ms;
+  // Peripheral clocks
+  PeriClock _peri_clock;
+  ClockChangeHook _hooks[PICOMIMI_MAX_CLOCK_HOOKS];
+  void* _hook_ctx[PICOMIMI_MAX_CLOCK_HOOKS];
+  
+  // Scaling - a repeating alarm either flags the decision for run() or,
+  // in SERVICE_TIMER, samples load in the alarm IRQ and pends a
+  // lowest-priority spare IRQ that makes the decision
+  GovernorService _service_mode;
+  repeating_timer_t _tick_timer;
+  alarm_pool_t* _tick_pool;      // The owner core's own pool, when it isn't core0
+  uint32_t _tick_ms;             // Interval the tick was armed with
+  int8_t _decide_irq;            // SERVICE_TIMER, -1 until claimed
+  volatile bool _core1_ready;
+  uint8_t _flash_depth;          // beginFlashWrite() nesting
+  static PicomimiGovernorClass* _timer_gov;
+  static PicomimiGovernorClass* _core1_gov;
+  volatile bool _decision_due;
+  volatile bool _busy;           // Level change in progress; the tick skips
+  bool _wfi_ok;
+  ScalingPolicy _policy;
+  uint8_t _base_level;
+  bool _pred_raised;
+  volatile bool _pred_dirty;     // A burst landed since the last _predict()
+  uint32_t _pred_next_us;        // Next window edge; run() skips _predict() until then
+  const PolicyOps* _ops;
+  PolicyState _pstate;
+  
+  // Deadline
+  uint32_t _deadline_us;
+  uint8_t _deadline_margin;
+  bool _task_manual;
+  uint64_t _task_start_us;
+  uint32_t _task_us;
+  uint32_t _task_cycles[PICOMIMI_TASK_HISTORY];   // us * MHz of recent iterations
+  uint8_t _task_head;
+  uint8_t _task_count;
+  uint32_t _deadline_misses;
+  
+  // Thermal
+  PolicyPid _pid;
+  uint8_t _cap_level;
+  
+  // Flash: QSPI divider in use, and the XIP cache over the last window
+  uint32_t _flash_max_khz;       // 0 = don't retune
+  uint32_t _flash_div;
+  uint32_t _flash_rx;            // RP2350 QMI RXDELAY in use
+  uint32_t _flash_rx0;           // ... and at boot, with
+  uint32_t _flash_rx0_khz;       // the boot clk_sys
+  uint8_t _xip_limit;            // Hit %, 0 = off
+  uint8_t _xip_cap;              // Level used while flash-bound
+  bool _xip_bound;
+  uint32_t _xip_hit;
+  uint32_t _xip_acc;
+  
+  // Bus counters: 0/1 XIP access/contested, 2/3 SRAM0 access/contested
+  uint8_t _bus_min_eff;          // 0 = classifier off
+  uint8_t _bus_eff;
+  
+  TempSampling _temp_mode;
+  PolicyTempFilter _temp_filter;
+  int32_t _temp_mc;              // Filtered
+  int32_t _temp_slope_mc;        // m°C/s
+  volatile bool _temp_reconfig;  // setTempSampling() owns the ADC
+  volatile bool _temp_reading;   // _sampleTemp() is on it
+  int _adc_dma;                  // -1 = none claimed
+  uint8_t _adc_order[5];         // Inputs in round-robin order
+  uint8_t _adc_count;
+  uint8_t _adc_inputs;           // App's inputs, kept to restart the ring
+  uint32_t _adc_rate_hz;
+  alignas(PICOMIMI_ADC_RING * 2) volatile uint16_t _adc_ring[PICOMIMI_ADC_RING];
   
   // Timers
   uint32_t _turbo_start_ms;
@@ -128,32 +929,259 @@ private:
   bool _throttled;
   bool _boost_on;
   bool _override_on;
-  PowerProfile _override_profile;
+  volatile bool _override_expired;   // Printed from _service(), never from a decision
+  uint8_t _override_level;
   bool _adc_init;
-  bool _first_run;
   
   // Tables
-  const uint32_t* _freq_tbl;
-  const uint32_t* _volt_tbl;
+  Opp _opps[PICOMIMI_MAX_OPPS];
+  PolicyOpp _table[PICOMIMI_MAX_OPPS];
+  uint8_t _opp_count;
+  uint8_t _custom_count;         // Set by setOperatingPoints(), checked in begin()
+  uint8_t _alias[PROFILE_COUNT];
+  bool _calibrated;
+  
+  // Residency
+  struct OppStats {
+    uint64_t time_us;
+    uint64_t energy_nj;
+    uint32_t entries;
+    uint32_t measured_ua;        // 0 = use the model
+  };
+  OppStats _stats[PICOMIMI_MAX_OPPS];
+  uint64_t _state_since_us;
+  float _current_scale;
+  
+  // Trace
+  TraceRecord _trace_buf[PICOMIMI_TRACE_SIZE];
+  uint16_t _trace_head;          // Next slot to write
+  uint16_t _trace_count;
+  volatile uint32_t _trace_seq;  // Writes started, for dumpTrace()
+  
+  // Telemetry
+  Print* _tm_out;
+  TelemetryCallback _tm_cb;
+  void* _tm_ctx;
+  volatile uint32_t _tm_period_ms;   // 0 = off, also while the sink changes
+  uint32_t _tm_next_ms;
+  uint16_t _tm_seq;
+  uint32_t _tm_res_us[PICOMIMI_MAX_OPPS];   // time_us at the last frame, low word
+  uint32_t _throttle_count;
+  uint8_t _tm_buf[PICOMIMI_TELEMETRY_MAX_FRAME];
+  
+  // QoS - slots change under a lock, the aggregate is what _scale() reads
+  struct QosSlot {
+    uint32_t khz;
+    uint32_t expires_ms;         // 0 = never
+    bool used;
+    bool ceiling;
+  };
+  QosSlot _qos[PICOMIMI_MAX_QOS];
+  uint32_t _qos_floor_khz;       // 0 = none
+  uint32_t _qos_ceil_khz;        // 0 = none
+  uint32_t _qos_next_expiry_ms;  // Earliest timeout, 0 = none
+  uint8_t _qos_floor;            // As levels
+  uint8_t _qos_ceil;
+  
+  spin_lock_t* _lock;            // Guards _qos, phases and the stages across cores; claimed in begin()
+  GovernorTunables _tune_stage;  // setTunables() waiting in the mailbox
+  const PolicyOps* _ops_stage;   // setPolicy(ops) waiting in the mailbox
+  
+  // Phase hints - what each id has learned, and a stack of running ones
+  struct PhaseSlot {
+    PhaseStats stats;
+    uint32_t budget_us;          // 0 = none
+    uint8_t level;               // Pinned by the next hint, PHASE_UNLEARNED = default
+  };
+  struct PhaseFrame {
+    uint8_t phase;
+    uint8_t pin;
+    uint8_t prev_level;
+    uint32_t start_us;
+  };
+  PhaseSlot _phases[PICOMIMI_MAX_PHASES];
+  PhaseFrame _phase_stack[PICOMIMI_PHASE_DEPTH];
+  volatile uint8_t _phase_depth;
+  volatile uint8_t _phase_pin;   // Innermost frame's level, read by _capLevel()
+  
+  // Cross-core control: one single-producer ring per calling core, all
+  // drained by the scaling context. Status goes the other way through a
+  // two-slot seqlock, so a reader interrupting the writer still finds a
+  // complete copy.
+  struct GovCommand {
+    uint8_t op;
+    uint8_t level;
+    uint32_t arg;
+  };
+  struct Mailbox {
+    GovCommand ring[PICOMIMI_MAILBOX_SIZE];
+    volatile uint8_t head;       // Written by the producing core
+    volatile uint8_t tail;       // Written by the scaling context
+  };
+  Mailbox _mbox[PICOMIMI_NUM_CORES];
+  volatile bool _mbox_pending;
+  volatile uint32_t _mbox_dropped;
+  GovernorStatus _snap[2];
+  volatile uint32_t _snap_seq;
   
   // Serial
-  String _cmd;
+  char _cmd[PICOMIMI_CMD_MAX];
+  uint8_t _cmd_len;
+  bool _cmd_overflow;            // Dropping the rest of an over-long line
+  static const SerialCommand _commands[];
   
   // Internal
   void _setupTables();
+  uint8_t _nearestLevel(uint32_t khz);
+  uint8_t _levelAtLeast(uint32_t khz);
+  uint8_t _profileOf(uint8_t level);
+  void _account(CoreLoad& c, uint32_t now_us);
+  void _service();
+  void _decide();
+  void _decideLevel();
+  static bool _onTick(repeating_timer_t* rt);
+  static void _onDecide();
+  void _armDecideIrq();
+  uint32_t _idleWork(CoreLoad& c, uint32_t period_us, uint32_t now_us);
+  void _armSampler(uint8_t core);
+  bool _sampleWork(uint8_t core, uint32_t period_us, uint32_t& work_us);
+  void _idleBegin(CoreLoad& c);
+  void _idleEnd(CoreLoad& c, uint64_t us);
   void _updateLoad();
+  load_q16_t _mixLoads(load_q16_t l0, load_q16_t l1);
   void _scale();
-  void _apply(PowerProfile p);
-  void _setFreq(uint32_t khz, uint32_t mv);
+  void _selectPolicy(uint8_t policy, const PolicyOps* ops);
+  LoadSample _loadSample();
+  void _analyzeBursts(CoreLoad& c);
+  bool _predict(uint32_t now);
+  void _recordTask(uint32_t us);
+  void _deadlineMove();
+  uint8_t _deadlineTarget();
+  uint8_t _capLevel(uint8_t level);
+  int _addRequest(uint32_t mhz, uint32_t timeout_ms, bool ceiling);
+  void _qosAggregate(uint32_t now_ms);
+  void _qosLevels();
+  void _qosApply();
+  void _qosMove();
+  void _phaseClear();
+  uint8_t _phaseTarget(uint8_t phase);
+  void _phaseLearn(const PhaseFrame& f, uint32_t us);
+  void _phaseApply(uint8_t level);
+  void _phaseMove(uint8_t level);
+  uint32_t _lockQos();
+  void _unlockQos(uint32_t irq);
+  bool _direct();
+  void _post(uint8_t op, uint8_t level, uint32_t arg);
+  void _drain();
+  void _execute(const GovCommand& cmd);
+  void _publish();
+  void _armTick();
+  static void _core1Entry();
+  void _core1Loop();
+  void _doOpp(uint8_t level, uint32_t duration_sec);
+  void _doBoost();
+  void _apply(uint8_t level, TraceReason why);
+  void _trace(uint8_t from, uint8_t to, TraceReason why);
+  void _telemetry();
+  void _accountState(uint64_t now_us);
+  uint32_t _modelCurrentUa(uint8_t level);
+  uint32_t _currentUa(uint8_t level);
+  void _printStats();
+  void _printPhases();
+  bool _setFreq(uint8_t level);
+  void _setSysPll(const PllConfig& pll);
+  uint32_t _flashDivFor(uint32_t khz);
+  uint32_t _flashRxFor(uint32_t div);
+  void _retuneFlash();
+  void _xipCapUpdate();
+  void _xipSample();
+  void _busSample();
+  void _parkOtherCore();
+  void _resumeOtherCore();
+  uint32_t _waitVreg();
+  void _applyPeriClock();
+  void _sampleTemp();
   void _thermal();
+  int32_t _readTempMc();
+  bool _adcStart();
+  void _adcStop();
+  uint8_t _adcRecent(uint8_t input, uint16_t* out, uint8_t max);
   void _timeouts();
   void _wfi();
+  void _sleepMasked(CoreLoad& c);
+  void _spinUntil(CoreLoad& c, uint64_t target_us);
+  void _idleFor(uint64_t us);
+  void _sleepUntil(uint64_t target_us);
+  bool _deepOk();
+  void _deepIdle(uint64_t target_us);
+  void _deepEnter();
+  void _deepExit();
   vreg_voltage _toVreg(uint32_t mv);
+  bool _loadCalibration();
+  bool _loadTunables();
+  PolicyTuning _policyTuning();
+  bool _setTunable(const char* name, uint32_t value);
+  void _applyTunables(const GovernorTunables& t);
+  void _printTunables();
+  bool _calTrial(uint32_t ref, uint32_t ms);
+  bool _flashLoad(uint8_t slot, void* data, size_t len);
+  bool _flashSave(uint8_t slot, const void* data, size_t len);
   void _handleSerial();
+  void _dispatch(char* line);
+  void _cmdUnknown();
+  void _cmdHelp(const char* arg);
+  void _cmdStatus(const char* arg);
+  void _cmdAuto(const char* arg);
+  void _cmdTurbo(const char* arg);
+  void _cmdSave(const char* arg);
+  void _cmdBal(const char* arg);
+  void _cmdPerf(const char* arg);
+  void _cmdUltra(const char* arg);
+  void _cmdOpps(const char* arg);
+  void _cmdOpp(const char* arg);
+  void _cmdCal(const char* arg);
+  void _cmdStats(const char* arg);
+  void _cmdTrace(const char* arg);
+  void _cmdGet(const char* arg);
+  void _cmdSet(const char* arg);
+  void _cmdSetSave(const char* arg);
+  void _cmdSetClear(const char* arg);
+  void _cmdPolicy(const char* arg);
+  void _cmdPhases(const char* arg);
   void _printHelp();
   void _printStatus();
+  void _printOpps();
 };
 
-extern PicomimiGovernorClass PicomimiGov;
+// ============================================================================
+// COMPILE-TIME CONFIGURED GOVERNOR
+// ============================================================================
+
+template <class Config = GovernorConfig>
+class PicomimiGovernor : public PicomimiGovernorClass {
+public:
+  PicomimiGovernor() : PicomimiGovernorClass(governorTunables<Config>()) {}
+};
+
+extern PicomimiGovernor<> PicomimiGov;
+
+// ============================================================================
+// PHASE SCOPE
+// ============================================================================
+
+// hint() for the lifetime of the object:
+//   { GovernorScope s(PHASE_COMPUTE); decodeJpeg(); }
+class GovernorScope {
+public:
+  explicit GovernorScope(uint8_t phase, PicomimiGovernorClass& gov = PicomimiGov)
+    : _gov(gov), _token(gov.hint(phase)) {}
+  ~GovernorScope() { _gov.hintEnd(_token); }
+  GovernorScope(const GovernorScope&) = delete;
+  GovernorScope& operator=(const GovernorScope&) = delete;
+  
+private:
+  PicomimiGovernorClass& _gov;
+  int _token;
+};
 
 #endif
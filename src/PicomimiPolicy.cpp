@@ -0,0 +1,310 @@
+/*
+ * PICOMIMI GOVERNOR - Scaling Policy
+ *
+ * No SDK or Arduino calls in here, so extras/sim can build it natively.
+ */
+
+#include "PicomimiPolicy.h"
+
+// ============================================================================
+// CONFIGURATION
+// ============================================================================
+
+#define TEMP_SMOOTH      0.3f    // The on-die sensor is about 0.5 °C per LSB
+
+// Thermal PID defaults
+#define PID_KP           8000.0f   // 8 MHz per °C over target
+#define PID_KI           1500.0f   // 1.5 MHz per °C per second
+#define PID_KD           5000.0f
+
+// Current model: static + dynamic x MHz x V for a busy core. A core in
+// WFE still draws part of the dynamic current (clocks and bus keep going).
+#define CUR_STATIC_UA_RP2040   1500
+#define CUR_UA_PER_MHZ_RP2040  150     // At CUR_REF_MV
+#define CUR_STATIC_UA_RP2350   2000
+#define CUR_UA_PER_MHZ_RP2350  110
+#define CUR_REF_MV             1100
+#define CUR_IDLE_SHARE_PCT     25
+
+// ============================================================================
+// TABLES
+// ============================================================================
+
+uint8_t policyBuiltin(PolicyOpp* t, bool rp2350, const PolicyTuning& tune) {
+  const uint32_t* freq = rp2350 ? PICOMIMI_RP2350_FREQ : PICOMIMI_RP2040_FREQ;
+  const uint16_t* volt = rp2350 ? PICOMIMI_RP2350_VOLT : PICOMIMI_RP2040_VOLT;
+  for (uint8_t i = 0; i < PICOMIMI_BUILTIN_OPPS; i++) {
+    t[i].khz = freq[i];
+    t[i].mv = volt[i];
+  }
+  policyThresholds(t, PICOMIMI_BUILTIN_OPPS, freq, tune);
+  return PICOMIMI_BUILTIN_OPPS;
+}
+
+// Exact for the built-in points, interpolated by frequency for anything
+// in between. ref_khz is the built-in frequency list.
+void policyThresholds(PolicyOpp* t, uint8_t n, const uint32_t* ref_khz, const PolicyTuning& tune) {
+  const uint8_t* UP = tune.up_pct;
+  const uint8_t* DOWN = tune.down_pct;
+  for (uint8_t i = 0; i < n; i++) {
+    uint32_t khz = t[i].khz;
+    uint8_t a = 0;
+    while (a + 1 < PICOMIMI_BUILTIN_OPPS && ref_khz[a + 1] <= khz) a++;
+    
+    if (a + 1 >= PICOMIMI_BUILTIN_OPPS || khz <= ref_khz[0]) {
+      t[i].up_pct = UP[a];
+      t[i].down_pct = DOWN[a];
+    } else {
+      uint32_t span = ref_khz[a + 1] - ref_khz[a];
+      uint32_t pos = khz - ref_khz[a];
+      t[i].up_pct = UP[a] + (uint8_t)((UP[a + 1] - UP[a]) * pos / span);
+      t[i].down_pct = DOWN[a] + (uint8_t)((DOWN[a + 1] - DOWN[a]) * pos / span);
+    }
+  }
+}
+
+uint8_t policyNearest(const PolicyOpp* t, uint8_t n, uint32_t khz) {
+  uint8_t best = 0;
+  uint32_t best_d = 0xFFFFFFFF;
+  for (uint8_t i = 0; i < n; i++) {
+    uint32_t f = t[i].khz;
+    uint32_t d = f > khz ? f - khz : khz - f;
+    if (d < best_d) { best = i; best_d = d; }
+  }
+  return best;
+}
+
+// Lowest level that runs at least khz, or the top one
+uint8_t policyAtLeast(const PolicyOpp* t, uint8_t n, uint32_t khz) {
+  uint8_t l = 0;
+  while (l + 1 < n && t[l].khz < khz) l++;
+  return l;
+}
+
+// Highest level that runs at most khz, or the bottom one
+uint8_t policyAtMost(const PolicyOpp* t, uint8_t n, uint32_t khz) {
+  uint8_t l = n - 1;
+  while (l > 0 && t[l].khz > khz) l--;
+  return l;
+}
+
+// ============================================================================
+// LOAD
+// ============================================================================
+
+// avg += (sample - avg) x weight; at most 100% x 100 fits in 32 bits
+load_q16_t policySmooth(load_q16_t avg, load_q16_t sample, uint8_t smooth_pct) {
+  int32_t d = (int32_t)sample - (int32_t)avg;
+  return (load_q16_t)((int32_t)avg + d * smooth_pct / 100);
+}
+
+// ============================================================================
+// DECISIONS
+// ============================================================================
+
+// Jump up to the highest level whose threshold the load has crossed,
+// step down one level at a time
+uint8_t policyLadder(const PolicyOpp* t, uint8_t n, uint8_t level, load_q16_t load, bool can_up) {
+  uint8_t target = level;
+
+  if (can_up) {
+    for (uint8_t l = n - 1; l > level; l--) {
+      if (load >= PICOMIMI_LOAD_Q16(t[l].up_pct)) { target = l; break; }
+    }
+  }
+
+  if (level > 0 && load < PICOMIMI_LOAD_Q16(t[level].down_pct)) target = level - 1;
+  return target;
+}
+
+// schedutil-style: the frequency the load needs, plus headroom
+uint8_t policySched(const PolicyOpp* t, uint8_t n, uint32_t khz, load_q16_t load, uint8_t headroom_pct) {
+  uint32_t want_khz = (uint32_t)((uint64_t)khz * load * headroom_pct / PICOMIMI_LOAD_Q16(100 * 100));
+  return policyAtLeast(t, n, want_khz);
+}
+
+// interactive-style: a window at hispeed_pct or more goes straight to the
+// top and stays at least hold_ms; otherwise the level is the one that
+// would put the instant load at target_pct, in either direction. No
+// smoothing, so a spike out of the bottom level costs one window.
+uint8_t policyInteractive(const PolicyOpp* t, uint8_t n, uint8_t level, load_q16_t instant,
+                          const PolicyTuning& tune, uint32_t& hold_left_ms, uint32_t dt_ms) {
+  if (instant >= PICOMIMI_LOAD_Q16(tune.hispeed_pct)) {
+    hold_left_ms = tune.hold_ms;
+    return n - 1;
+  }
+  
+  uint32_t want_khz = (uint32_t)((uint64_t)t[level].khz * instant / PICOMIMI_LOAD_Q16(tune.target_pct));
+  uint8_t target = policyAtLeast(t, n, want_khz);
+  if (hold_left_ms > 0) {
+    hold_left_ms = hold_left_ms > dt_ms ? hold_left_ms - dt_ms : 0;
+    if (target < level) target = level;
+  }
+  return target;
+}
+
+// Slowest level that fits the worst recent iteration into the deadline
+// minus its margin
+uint8_t policyDeadline(const PolicyOpp* t, uint8_t n, uint32_t worst_cycles,
+                       uint32_t deadline_us, uint8_t margin_pct) {
+  uint32_t budget_us = deadline_us * (100 - margin_pct) / 100;
+  if (budget_us == 0) budget_us = 1;
+  uint32_t want_khz = (uint32_t)((uint64_t)worst_cycles * 1000 / budget_us);
+  return policyAtLeast(t, n, want_khz);
+}
+
+// ============================================================================
+// POLICY TARGETS
+// ============================================================================
+
+uint8_t policyTargetLadder(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                           const PolicyTuning& tune, PolicyState& state) {
+  (void)tune; (void)state;
+  return policyLadder(t, n, s.level, s.avg_load, s.level < s.ceiling);
+}
+
+// conservative-style: heads for the schedutil target one level per
+// decision, so neither a spike nor a lull moves the clock far
+uint8_t policyTargetConservative(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                                 const PolicyTuning& tune, PolicyState& state) {
+  (void)state;
+  uint8_t want = policySched(t, n, t[s.level].khz, s.avg_load, tune.headroom_pct);
+  if (want > s.level && s.level < s.ceiling) return s.level + 1;
+  if (want < s.level && s.level > s.floor) return s.level - 1;
+  return s.level;
+}
+
+// ondemand-style: a busy window goes to the top, anything else maps the
+// load linearly onto the table's range
+uint8_t policyTargetOndemand(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                             const PolicyTuning& tune, PolicyState& state) {
+  (void)state;
+  if (s.instant_load >= PICOMIMI_LOAD_Q16(tune.hispeed_pct)) return n - 1;
+  uint32_t span = t[n - 1].khz - t[0].khz;
+  uint32_t want_khz = t[0].khz + (uint32_t)((uint64_t)span * s.instant_load / PICOMIMI_LOAD_Q16(100));
+  return policyAtLeast(t, n, want_khz);
+}
+
+uint8_t policyTargetSched(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                          const PolicyTuning& tune, PolicyState& state) {
+  (void)state;
+  return policySched(t, n, t[s.level].khz, s.avg_load, tune.headroom_pct);
+}
+
+uint8_t policyTargetInteractive(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                                const PolicyTuning& tune, PolicyState& state) {
+  return policyInteractive(t, n, s.level, s.instant_load, tune, state.hold_left_ms, s.interval_ms);
+}
+
+uint8_t policyTargetPowersave(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                              const PolicyTuning& tune, PolicyState& state) {
+  (void)t; (void)n; (void)s; (void)tune; (void)state;
+  return 0;
+}
+
+uint8_t policyTargetPerformance(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                                const PolicyTuning& tune, PolicyState& state) {
+  (void)t; (void)s; (void)tune; (void)state;
+  return n - 1;
+}
+
+// ============================================================================
+// THERMAL
+// ============================================================================
+
+// T = 27 - (V - 0.706) / 0.001721, in uV and m°C: 1000 / 1.721 ~ 581 / 1000
+int32_t policyTempMc(uint16_t raw) {
+  int32_t uv = (int32_t)(((uint32_t)raw * 825000u) >> 10);   // x 3.3 V / 4096
+  return 27000 - (uv - 706000) * 581 / 1000;
+}
+
+uint16_t policyMedian(uint16_t* v, uint8_t n) {
+  if (n == 0) return 0;
+  for (uint8_t i = 1; i < n; i++) {
+    uint16_t x = v[i];
+    uint8_t j = i;
+    while (j > 0 && v[j - 1] > x) { v[j] = v[j - 1]; j--; }
+    v[j] = x;
+  }
+  return v[n / 2];
+}
+
+int32_t policyTempFilter(PolicyTempFilter& f, int32_t mc) {
+  if (f.count == 0) f.ema_q4 = mc * 16;
+  else f.ema_q4 += (mc * 16 - f.ema_q4) >> 2;
+
+  int32_t out = f.ema_q4 >> 4;
+  f.hist_mc[f.head] = out;
+  f.head = (f.head + 1) % PICOMIMI_TEMP_HISTORY;
+  if (f.count < PICOMIMI_TEMP_HISTORY) f.count++;
+  return out;
+}
+
+// Least squares over evenly spaced samples: x = 2i - (n - 1), so the
+// x's are symmetric integers and sum(x) = 0
+int32_t policyTempSlope(const PolicyTempFilter& f, uint32_t step_ms) {
+  uint8_t n = f.count;
+  if (n < 2 || step_ms == 0) return 0;
+  int64_t sxy = 0, sxx = 0;
+  for (uint8_t i = 0; i < n; i++) {
+    uint8_t idx = (f.head + PICOMIMI_TEMP_HISTORY - n + i) % PICOMIMI_TEMP_HISTORY;
+    int32_t x = 2 * i - (n - 1);
+    sxy += (int64_t)x * f.hist_mc[idx];
+    sxx += (int64_t)x * x;
+  }
+  // slope per step = 2 * sxy / sxx
+  return (int32_t)(2 * sxy * 1000 / (sxx * (int64_t)step_ms));
+}
+
+void policyPidInit(PolicyPid& p, float target_c) {
+  p.target_c = target_c;
+  p.kp = PID_KP;
+  p.ki = PID_KI;
+  p.kd = PID_KD;
+  policyPidReset(p, 0);
+}
+
+void policyPidReset(PolicyPid& p, uint32_t khz) {
+  p.integral_khz = (float)khz;
+  p.filtered_c = 0;
+  p.primed = false;
+}
+
+uint32_t policyPid(PolicyPid& p, float temp_c, float dt_s, uint32_t min_khz, uint32_t max_khz) {
+  float prev = p.filtered_c;
+  p.filtered_c = p.primed ? (prev * (1.0f - TEMP_SMOOTH)) + (temp_c * TEMP_SMOOTH) : temp_c;
+  float slope = p.primed && dt_s > 0 ? (p.filtered_c - prev) / dt_s : 0.0f;
+  p.primed = true;
+
+  // Positive error = headroom
+  float err = p.target_c - p.filtered_c;
+
+  // Clamping the integral to the table range is the anti-windup
+  p.integral_khz += p.ki * err * dt_s;
+  if (p.integral_khz > max_khz) p.integral_khz = (float)max_khz;
+  if (p.integral_khz < min_khz) p.integral_khz = (float)min_khz;
+
+  float out = p.integral_khz + p.kp * err - p.kd * slope;
+  if (out > max_khz) return max_khz;
+  if (out < min_khz) return min_khz;
+  return (uint32_t)out;
+}
+
+// ============================================================================
+// CURRENT MODEL
+// ============================================================================
+
+uint32_t policyCurrentUa(const PolicyOpp& o, uint8_t busy_pct, bool rp2350) {
+  uint32_t stat = rp2350 ? CUR_STATIC_UA_RP2350 : CUR_STATIC_UA_RP2040;
+  uint32_t per_mhz = rp2350 ? CUR_UA_PER_MHZ_RP2350 : CUR_UA_PER_MHZ_RP2040;
+  uint32_t dyn = per_mhz * (o.khz / 1000) * o.mv / CUR_REF_MV;
+  uint32_t share = CUR_IDLE_SHARE_PCT + (100 - CUR_IDLE_SHARE_PCT) * busy_pct / 100;
+  return stat + dyn * share / 100;
+}
+
+uint32_t policyBreakEvenUs(uint32_t lat_us, uint32_t busy_ua, uint32_t shallow_ua, uint32_t deep_ua) {
+  if (shallow_ua <= deep_ua) return 0xFFFFFFFF;
+  uint32_t cost = busy_ua > deep_ua ? busy_ua - deep_ua : 0;
+  uint64_t us = (uint64_t)lat_us * cost / (shallow_ua - deep_ua);
+  return us > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)us;
+}
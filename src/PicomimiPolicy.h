@@ -0,0 +1,191 @@
+/*
+ * PICOMIMI GOVERNOR - Scaling Policy
+ *
+ * The half of the governor that decides, with no hardware in it: the
+ * built-in tables, ladder thresholds, load smoothing, level selection
+ * and the current model. PicomimiGovernor feeds it measurements;
+ * extras/sim feeds it recorded traces on a PC. Plain C++, stdint only.
+ */
+
+#ifndef PICOMIMI_POLICY_H
+#define PICOMIMI_POLICY_H
+
+#include <stdint.h>
+
+// ============================================================================
+// TIMING
+// ============================================================================
+
+#define PICOMIMI_LOAD_PERIOD_MS     200   // Load window
+#define PICOMIMI_SCALE_INTERVAL_MS  100   // Decision rate
+
+// ============================================================================
+// BUILT-IN TABLES
+// ============================================================================
+
+// One entry per PowerProfile, ULTRA_LOW..TURBO
+#define PICOMIMI_BUILTIN_OPPS 5
+
+static constexpr uint32_t PICOMIMI_RP2040_FREQ[] = { 50000, 100000, 133000, 200000, 250000 };
+static constexpr uint16_t PICOMIMI_RP2040_VOLT[] = { 950, 1000, 1050, 1100, 1150 };
+static constexpr uint32_t PICOMIMI_RP2350_FREQ[] = { 50000, 100000, 150000, 250000, 300000 };
+static constexpr uint16_t PICOMIMI_RP2350_VOLT[] = { 950, 1000, 1050, 1100, 1250 };
+
+// ============================================================================
+// TUNING
+// ============================================================================
+
+// Defaults; PicomimiGovernor<Config> overrides them per build
+#define PICOMIMI_TURBO_UP            70    // Ladder thresholds, load %
+#define PICOMIMI_TURBO_DOWN          55
+#define PICOMIMI_PERF_UP             45
+#define PICOMIMI_PERF_DOWN           30
+#define PICOMIMI_BAL_UP              20
+#define PICOMIMI_BAL_DOWN            12
+#define PICOMIMI_SAVE_DOWN           5
+#define PICOMIMI_LOAD_SMOOTH_PCT     30    // Weight of each new load window
+#define PICOMIMI_SCHED_HEADROOM_PCT  125   // schedutil target over what the load needs
+#define PICOMIMI_HISPEED_PCT         85    // Interactive: instant load that jumps to the top
+#define PICOMIMI_TARGET_PCT          70    // Interactive: load the proportional step aims for
+#define PICOMIMI_HISPEED_HOLD_MS     500   // Interactive: minimum time held after a jump
+
+// Load is percent in 16.16 fixed point, so no float on the M0+
+typedef uint32_t load_q16_t;
+#define PICOMIMI_LOAD_Q16(pct)  ((load_q16_t)(pct) << 16)
+
+struct PolicyTuning {
+  uint8_t up_pct[PICOMIMI_BUILTIN_OPPS];     // Into each built-in point
+  uint8_t down_pct[PICOMIMI_BUILTIN_OPPS];   // Out of it
+  uint8_t smooth_pct;
+  uint8_t headroom_pct;
+  uint8_t hispeed_pct;
+  uint8_t target_pct;
+  uint32_t hold_ms;
+};
+
+static constexpr PolicyTuning PICOMIMI_DEFAULT_TUNING = {
+  { 0, PICOMIMI_BAL_UP, PICOMIMI_BAL_UP, PICOMIMI_PERF_UP, PICOMIMI_TURBO_UP },
+  { 0, PICOMIMI_SAVE_DOWN, PICOMIMI_BAL_DOWN, PICOMIMI_PERF_DOWN, PICOMIMI_TURBO_DOWN },
+  PICOMIMI_LOAD_SMOOTH_PCT, PICOMIMI_SCHED_HEADROOM_PCT,
+  PICOMIMI_HISPEED_PCT, PICOMIMI_TARGET_PCT, PICOMIMI_HISPEED_HOLD_MS
+};
+
+// ============================================================================
+// POLICY
+// ============================================================================
+
+// An operating point as the policy sees it; up/down are the ladder
+// thresholds (load %) for moving into / out of it
+struct PolicyOpp {
+  uint32_t khz;
+  uint16_t mv;
+  uint8_t up_pct;
+  uint8_t down_pct;
+};
+
+// Tables. Levels are indices into a table sorted by rising khz.
+uint8_t policyBuiltin(PolicyOpp* t, bool rp2350, const PolicyTuning& tune);  // Fills t, returns count
+void policyThresholds(PolicyOpp* t, uint8_t n, const uint32_t* ref_khz, const PolicyTuning& tune);
+uint8_t policyNearest(const PolicyOpp* t, uint8_t n, uint32_t khz);
+uint8_t policyAtLeast(const PolicyOpp* t, uint8_t n, uint32_t khz);
+uint8_t policyAtMost(const PolicyOpp* t, uint8_t n, uint32_t khz);
+
+// One load window into the running average
+load_q16_t policySmooth(load_q16_t avg, load_q16_t sample, uint8_t smooth_pct);
+
+// Decisions. Each returns the level wanted, before any thermal cap.
+uint8_t policyLadder(const PolicyOpp* t, uint8_t n, uint8_t level, load_q16_t load, bool can_up);
+uint8_t policySched(const PolicyOpp* t, uint8_t n, uint32_t khz, load_q16_t load, uint8_t headroom_pct);
+uint8_t policyInteractive(const PolicyOpp* t, uint8_t n, uint8_t level, load_q16_t instant,
+                          const PolicyTuning& tune, uint32_t& hold_left_ms, uint32_t dt_ms);
+uint8_t policyDeadline(const PolicyOpp* t, uint8_t n, uint32_t worst_cycles,
+                       uint32_t deadline_us, uint8_t margin_pct);
+
+// Pluggable policies: one LoadSample in per decision, the wanted level
+// out. Floor and ceiling are applied afterwards by the caller; they are
+// here so a policy can avoid winding up against them. state is scratch
+// owned by the caller and zeroed whenever the policy is selected.
+struct LoadSample {
+  load_q16_t instant_load;   // Last window
+  load_q16_t avg_load;       // Smoothed
+  int32_t temp_mc;
+  uint8_t level;             // Current point
+  uint8_t floor;             // Lowest allowed (QoS floor)
+  uint8_t ceiling;           // Highest allowed (QoS ceiling, thermal cap)
+  uint8_t efficiency_pct;    // Bus accesses that didn't wait; 100 = clock-bound
+  uint32_t interval_ms;      // Since the last decision
+};
+
+struct PolicyState {
+  uint32_t hold_left_ms;     // interactive
+  uint32_t user;             // Free for custom policies
+};
+
+typedef uint8_t (*PolicyTargetFn)(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                                  const PolicyTuning& tune, PolicyState& state);
+
+struct PolicyOps {
+  const char* name;
+  PolicyTargetFn target;
+};
+
+// Built-in targets
+uint8_t policyTargetLadder(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                           const PolicyTuning& tune, PolicyState& state);
+uint8_t policyTargetConservative(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                                 const PolicyTuning& tune, PolicyState& state);
+uint8_t policyTargetOndemand(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                             const PolicyTuning& tune, PolicyState& state);
+uint8_t policyTargetSched(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                          const PolicyTuning& tune, PolicyState& state);
+uint8_t policyTargetInteractive(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                                const PolicyTuning& tune, PolicyState& state);
+uint8_t policyTargetPowersave(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                              const PolicyTuning& tune, PolicyState& state);
+uint8_t policyTargetPerformance(const PolicyOpp* t, uint8_t n, const LoadSample& s,
+                                const PolicyTuning& tune, PolicyState& state);
+
+// Thermal: PID on temperature whose output is the highest frequency
+// allowed. The integral starts (and saturates) at the table top, so a
+// cool chip is never capped; above target it settles at the frequency
+// that holds the target. Derivative acts on the filtered measurement.
+struct PolicyPid {
+  float target_c;
+  float kp;              // kHz per °C of error
+  float ki;              // kHz per °C·s
+  float kd;              // kHz per °C/s of temperature slope
+  float integral_khz;
+  float filtered_c;
+  bool primed;
+};
+
+// Temperature, integer only: raw 12-bit sensor reading to m°C, the
+// median of a burst of readings, then an EMA and a least-squares slope
+// over the last PICOMIMI_TEMP_HISTORY filtered values.
+#define PICOMIMI_TEMP_HISTORY 16
+
+struct PolicyTempFilter {
+  int32_t ema_q4;                          // m°C << 4
+  int32_t hist_mc[PICOMIMI_TEMP_HISTORY];
+  uint8_t head;
+  uint8_t count;
+};
+
+int32_t policyTempMc(uint16_t raw);
+uint16_t policyMedian(uint16_t* v, uint8_t n);              // Sorts v
+int32_t policyTempFilter(PolicyTempFilter& f, int32_t mc);   // Returns filtered m°C
+int32_t policyTempSlope(const PolicyTempFilter& f, uint32_t step_ms);  // m°C/s
+
+void policyPidInit(PolicyPid& p, float target_c);
+void policyPidReset(PolicyPid& p, uint32_t khz);
+uint32_t policyPid(PolicyPid& p, float temp_c, float dt_s, uint32_t min_khz, uint32_t max_khz);
+
+// Core current at a point, busy_pct of the time running (the rest in WFE)
+uint32_t policyCurrentUa(const PolicyOpp& o, uint8_t busy_pct, bool rp2350);
+
+// Shortest idle window where a deeper state saves energy: lat_us spent
+// switching at busy_ua has to be repaid at shallow_ua - deep_ua.
+// 0xFFFFFFFF if the deeper state draws no less.
+uint32_t policyBreakEvenUs(uint32_t lat_us, uint32_t busy_ua, uint32_t shallow_ua, uint32_t deep_ua);
+
+#endif